@@ -0,0 +1,170 @@
+#include "AsyncInferenceWorker.h"
+
+namespace {
+    void writeToRing(juce::AbstractFifo& fifo, std::vector<float>& ring, const float* src, int numSamples) {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+        if (src != nullptr) {
+            if (size1 > 0) juce::FloatVectorOperations::copy(ring.data() + start1, src, size1);
+            if (size2 > 0) juce::FloatVectorOperations::copy(ring.data() + start2, src + size1, size2);
+        } else {
+            if (size1 > 0) juce::FloatVectorOperations::clear(ring.data() + start1, size1);
+            if (size2 > 0) juce::FloatVectorOperations::clear(ring.data() + start2, size2);
+        }
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    // dest == nullptr just drops the samples
+    int readFromRing(juce::AbstractFifo& fifo, const std::vector<float>& ring, float* dest, int numSamples) {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(numSamples, start1, size1, start2, size2);
+        if (dest != nullptr) {
+            if (size1 > 0) juce::FloatVectorOperations::copy(dest, ring.data() + start1, size1);
+            if (size2 > 0) juce::FloatVectorOperations::copy(dest + size1, ring.data() + start2, size2);
+        }
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+}
+
+AsyncInferenceWorker::AsyncInferenceWorker(FrameProcessor& processor)
+    : frameProcessor(processor) {
+}
+
+AsyncInferenceWorker::~AsyncInferenceWorker() {
+    stop();
+}
+
+void AsyncInferenceWorker::prepare(int newFrameLength, int maxModelBlockSize) {
+    jassert(!registered);
+    frameLength = newFrameLength;
+
+    // a block pushed in one callback comes back in the next: one block, plus up to a hop
+    // of it still waiting to be completed
+    lowPrimeSamples = maxModelBlockSize + frameLength - 1;
+    safePrimeSamples = 2 * maxModelBlockSize + 2 * frameLength;
+    // offline, a few blocks of slack let the host thread run ahead of inference instead of taking turns
+    offlinePrimeSamples = 4 * maxModelBlockSize + FrameProcessor::maxFrames * frameLength;
+    activePrimeSamples = safePrimeSamples;
+
+    // at least a second of hops, whatever rate the model runs at
+    int capacity = juce::jmax(100 * frameLength, 4 * (offlinePrimeSamples + frameLength));
+    inputFifo.setTotalSize(capacity);
+    outputFifo.setTotalSize(capacity);
+    inputRing.assign(capacity, 0.0f);
+    outputRing.assign(capacity, 0.0f);
+    frameIn.assign(FrameProcessor::maxFrames * frameLength, 0.0f);
+    frameOut.assign(FrameProcessor::maxFrames * frameLength, 0.0f);
+
+    state.store(State::parked);
+}
+
+void AsyncInferenceWorker::start() {
+    if (registered) return;
+    if (!scheduler) scheduler.emplace();
+    (*scheduler)->add(this);
+    registered = true;
+}
+
+void AsyncInferenceWorker::stop() {
+    if (registered) {
+        (*scheduler)->remove(this);
+        registered = false;
+    }
+    state.store(State::parked);
+}
+
+void AsyncInferenceWorker::activate(Priming priming) {
+    jassert(isParked());
+    blocking = priming == Priming::offline;
+    activePrimeSamples = priming == Priming::low    ? lowPrimeSamples
+                       : priming == Priming::safe   ? safePrimeSamples
+                                                    : offlinePrimeSamples;
+    inputFifo.reset();
+    outputFifo.reset();
+    writeToRing(outputFifo, outputRing, nullptr, activePrimeSamples);
+    deficit = 0;
+    gap = 0;
+    state.store(State::running);
+}
+
+void AsyncInferenceWorker::requestDeactivate() {
+    auto expected = State::running;
+    if (state.compare_exchange_strong(expected, State::stopRequested) && registered)
+        (*scheduler)->wake();
+}
+
+bool AsyncInferenceWorker::push(const float* data, int numSamples) {
+    int toWrite = juce::jmin(numSamples, inputFifo.getFreeSpace());
+    writeToRing(inputFifo, inputRing, data, toWrite);
+    if (registered && inputFifo.getNumReady() >= frameLength)
+        (*scheduler)->wake();
+    if (toWrite == numSamples) return true;
+    gap += numSamples - toWrite;
+    droppedInputs.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool AsyncInferenceWorker::pull(float* dest, int numSamples) {
+    // offline there is no deadline: wait for the scheduler rather than drop audio
+    if (blocking && outputFifo.getNumReady() < numSamples && registered) {
+        // output space may be what held the last hops back
+        (*scheduler)->wake();
+        auto start = juce::Time::getMillisecondCounter();
+        while (outputFifo.getNumReady() < numSamples && state.load() == State::running
+               && juce::Time::getMillisecondCounter() - start < 2000)
+            juce::Thread::yield();
+    }
+
+    // samples we already zero-padded for arrived late: drop them to stay aligned
+    if (deficit > 0)
+        deficit -= readFromRing(outputFifo, outputRing, nullptr, juce::jmin(deficit, outputFifo.getNumReady()));
+
+    int samplesRead = readFromRing(outputFifo, outputRing, dest, juce::jmin(numSamples, outputFifo.getNumReady()));
+    if (samplesRead < numSamples) {
+        const int missing = numSamples - samplesRead;
+        juce::FloatVectorOperations::clear(dest + samplesRead, missing);
+        // dropped input never comes back, so its padding needs no skipping
+        const int fromGap = juce::jmin(gap, missing);
+        gap -= fromGap;
+        deficit += missing - fromGap;
+        lateFrames.fetch_add(1);
+        return false;
+    }
+    return true;
+}
+
+bool AsyncInferenceWorker::processAvailableFrames() {
+    bool didWork = false;
+    for (;;) {
+        // every hop that is ready, in as few calls as possible
+        int numFrames = juce::jmin(inputFifo.getNumReady() / frameLength, outputFifo.getFreeSpace() / frameLength,
+                                   (int)FrameProcessor::maxFrames);
+        numFrames = frameProcessor.getNumFramesReady(numFrames);
+        if (numFrames <= 0) break;
+
+        const int numSamples = numFrames * frameLength;
+        readFromRing(inputFifo, inputRing, frameIn.data(), numSamples);
+        frameProcessor.processFrames(frameIn.data(), frameOut.data(), numFrames);
+        writeToRing(outputFifo, outputRing, frameOut.data(), numSamples);
+        didWork = true;
+    }
+    return didWork;
+}
+
+bool AsyncInferenceWorker::service() {
+    bool expected = false;
+    if (!busy.compare_exchange_strong(expected, true)) return false;
+
+    bool didWork = false;
+    auto current = state.load();
+    if (current == State::stopRequested) {
+        state.store(State::parked);
+        didWork = true;
+    } else if (current == State::running) {
+        didWork = processAvailableFrames();
+    }
+
+    busy.store(false);
+    return didWork;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "InferenceScheduler.h"
+#include <atomic>
+#include <optional>
+#include <vector>
+
+// Turns runs of model-rate hops into others; implemented by whatever owns the model state.
+class FrameProcessor {
+public:
+    // most hops handed over in one processFrames() call
+    static constexpr int maxFrames = 8;
+
+    virtual ~FrameProcessor() = default;
+    // how many of the next `wanted` hops can run now; fewer while they depend on something not there yet
+    virtual int getNumFramesReady(int wanted) const { return wanted; }
+    virtual void processFrames(const float* input, float* output, int numFrames) = 0;
+};
+
+// Runs DeepFilterNet inference off the audio thread, on the shared InferenceScheduler.
+// The audio thread only pushes model-rate samples in and pulls finished samples out
+// through two lock-free SPSC rings; it never calls df_process_frame itself. A push that
+// completes a hop wakes a scheduler thread right away.
+class AsyncInferenceWorker {
+public:
+    explicit AsyncInferenceWorker(FrameProcessor& processor);
+    ~AsyncInferenceWorker();
+
+    // call while stopped
+    void prepare(int frameLength, int maxModelBlockSize);
+    // register with / unregister from the scheduler; stop() returns once no thread is inside
+    void start();
+    void stop();
+
+    // how far the output is primed ahead of the audio thread
+    enum class Priming {
+        low,    // one host block plus the hop being collected: just enough if the worker keeps up
+        safe,   // another block and hop of slack, for large or irregular host buffers
+        offline // several blocks, and pull() waits for results instead of zero-padding
+    };
+
+    // audio thread: only valid while parked, resets the rings and starts inference
+    void activate(Priming priming = Priming::safe);
+    // audio thread: asks the worker to park after its current frame
+    void requestDeactivate();
+    bool isParked() const { return state.load() == State::parked; }
+
+    // false if the input ring was full and part of data was dropped; pull() later pads that
+    // many zeros in its place, so the output stays aligned
+    bool push(const float* data, int numSamples);
+    // false if part of dest had to be zero-padded
+    bool pull(float* dest, int numSamples);
+
+    // extra delay in model-rate samples introduced by the output priming
+    int getAddedLatency() const { return activePrimeSamples; }
+    // the largest of them, offline priming; after prepare()
+    int getMaxAddedLatency() const { return juce::jmax(lowPrimeSamples, safePrimeSamples, offlinePrimeSamples); }
+    // number of pulls that had to be zero-padded because a frame was not back in time
+    juce::uint32 getLateFrameCount() const { return lateFrames.load(); }
+    // number of pushes that didn't fit
+    juce::uint32 getDroppedInputCount() const { return droppedInputs.load(); }
+    // most samples either ring holds
+    int getCapacity() const { return inputFifo.getTotalSize(); }
+    // samples waiting on either side of the worker
+    int getInputFill() const { return inputFifo.getNumReady(); }
+    int getOutputFill() const { return outputFifo.getNumReady(); }
+
+    // scheduler thread: runs every ready frame, returns false if there was nothing to do
+    bool service();
+
+private:
+    enum class State { parked, running, stopRequested };
+
+    bool processAvailableFrames();
+
+    FrameProcessor& frameProcessor;
+    // only taken on start(), so offline users never spin up the scheduler threads
+    std::optional<juce::SharedResourcePointer<InferenceScheduler>> scheduler;
+    bool registered = false;
+    std::atomic<bool> busy { false }; // claimed by a scheduler thread
+
+    juce::AbstractFifo inputFifo { 1 };
+    juce::AbstractFifo outputFifo { 1 };
+    std::vector<float> inputRing;
+    std::vector<float> outputRing;
+    std::vector<float> frameIn;
+    std::vector<float> frameOut;
+
+    int frameLength = 480;
+    int lowPrimeSamples = 0;
+    int safePrimeSamples = 0;
+    int offlinePrimeSamples = 0;
+    int activePrimeSamples = 0;
+    bool blocking = false;
+    int deficit = 0; // samples zero-padded by pull() that still have to be skipped
+    int gap = 0;     // samples push() dropped, which pull() pads instead of skipping them later
+
+    std::atomic<State> state { State::parked };
+    std::atomic<juce::uint32> lateFrames { 0 };
+    std::atomic<juce::uint32> droppedInputs { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AsyncInferenceWorker)
+};
@@ -0,0 +1,432 @@
+#include "ChannelProcessor.h"
+
+namespace {
+    // the resampler doesn't report its delay: send an impulse through a fresh one, host rate
+    // to the model's and back, and see where it comes out
+    int measureResamplerLatency(double sampleRate, double modelRate, int blockSize, int maxModelBlockSize) {
+        Resampler<1, 1> probe(sampleRate, modelRate);
+        std::vector<float> signal((size_t)juce::roundToInt(sampleRate * 0.1), 0.0f);
+        std::vector<float> modelIn((size_t)maxModelBlockSize), modelOut((size_t)maxModelBlockSize);
+        signal[0] = 1.0f;
+
+        for (int pos = 0; pos < (int)signal.size(); pos += blockSize) {
+            float* block[] = { signal.data() + pos };
+            float* targetIn[] = { modelIn.data() };
+            float* targetOut[] = { modelOut.data() };
+            probe.process(block, block, targetIn, targetOut, juce::jmin(blockSize, (int)signal.size() - pos),
+                          [](float* const* input, float* const* output, int n) {
+                              std::copy(input[0], input[0] + n, output[0]);
+                          });
+        }
+        auto peak = std::max_element(signal.begin(), signal.end(), [](float a, float b) { return std::abs(a) < std::abs(b); });
+        return (int)std::distance(signal.begin(), peak);
+    }
+}
+
+ChannelProcessor::ChannelProcessor() {
+    dfProcessor = std::make_unique<DeepFilterNetProcessor>();
+    asyncWorker = std::make_unique<AsyncInferenceWorker>(*this);
+}
+
+ChannelProcessor::~ChannelProcessor() {
+    asyncWorker->stop();
+}
+
+bool ChannelProcessor::initialize(int variant) {
+    return dfProcessor->initialize(variant);
+}
+
+void ChannelProcessor::adoptPendingModel() {
+    jassert(asyncWorker->isParked());
+    // a model at another rate waits for the next prepare(), which resizes everything for it
+    if (!dfProcessor->adoptPending(modelRate)) return;
+    // variants at one rate share the hop size, only the lookahead differs; prepare() reserved for the longest
+    jassert(dfProcessor->getFrameLength() == frameLength);
+    gate.prepare(frameLength, getModelDelay());
+    appliedAttenLim = -1.0f;
+}
+
+void ChannelProcessor::prepare(double sampleRate, int samplesPerBlock, bool withAsyncWorker) {
+    asyncWorker->stop();
+    asyncActive = false;
+    dfProcessor->adoptPending();
+    frameLength = dfProcessor->getFrameLength();
+    modelRate = dfProcessor->getSampleRate();
+    hostSampleRate = sampleRate;
+
+    // sized for the longest lookahead first, so adoptPendingModel() never allocates
+    gate.prepare(frameLength, (1 + ModelCache::getMaxLookaheadHops()) * frameLength);
+    gate.prepare(frameLength, getModelDelay());
+    prerollOutput.assign(frameLength, 0.0f);
+
+    // init resampler; the model's own rate needs none and twice it is an exact 2:1.
+    // common rates get the polyphase tables, anything else the generic resampler
+    if (sampleRate == (double)modelRate) ratePath = RatePath::native;
+    else if (sampleRate == 2.0 * modelRate) ratePath = RatePath::halfband;
+    else if (polyphase.prepare(sampleRate, modelRate)) ratePath = RatePath::polyphase;
+    else ratePath = RatePath::resampled;
+    double maxRatio = juce::jmax(1.0, modelRate / sampleRate);
+    int maxResampledSize = (int)(samplesPerBlock * maxRatio) + 128; // +128 for safety margin
+    if (ratePath == RatePath::polyphase)
+        maxResampledSize = juce::jmax(maxResampledSize, polyphase.getMaxModelSamples(samplesPerBlock));
+    resampleInBuffer.resize(maxResampledSize);
+    resampleOutBuffer.resize(maxResampledSize);
+    resamplerHandler.reset();
+    resamplerLatency = 0;
+    if (ratePath == RatePath::resampled) {
+        resamplerHandler = std::make_unique<Resampler<1, 1>>(sampleRate, (double)modelRate);
+        resamplerLatency = measureResamplerLatency(sampleRate, modelRate, samplesPerBlock, maxResampledSize);
+    }
+    halfband.reset();
+    polyphase.reset();
+
+    // the largest run of model-rate samples one host block turns into; only the resampler's isn't exact
+    int maxModelBlockSize = ratePath == RatePath::native    ? samplesPerBlock
+                          : ratePath == RatePath::halfband  ? (samplesPerBlock + 1) / 2
+                          : ratePath == RatePath::polyphase ? polyphase.getMaxModelSamples(samplesPerBlock)
+                                                            : maxResampledSize;
+    // runs of frames are read from and written to ring memory directly. Sync, the input holds
+    // a block plus less than a hop, or for a linked side a backlog of hops waiting on the mid's
+    // gains; the output the priming plus what a block completes
+    const int ringSize = maxModelBlockSize + (maxFrames + 1) * frameLength;
+    inputFifo.setSize(ringSize, maxFrames * frameLength);
+    outputFifo.setSize(ringSize, maxFrames * frameLength);
+    asyncWorker->prepare(frameLength, maxModelBlockSize);
+    blockMs = 1000.0 * samplesPerBlock / sampleRate;
+    maxHopsPerBlock = juce::jmax(1, (maxModelBlockSize + frameLength - 1) / frameLength);
+    if (withAsyncWorker)
+        asyncWorker->start();
+    appliedAttenLim = -1.0f;
+}
+
+int ChannelProcessor::getLatency() const {
+    // the model's lookahead plus the zeros the output was primed with; neither FIFO adds more,
+    // since the output never runs dry once primed
+    return toHostLatency(getModelDelay() + (asyncActive ? asyncWorker->getAddedLatency() : getSyncPrimeSamples()));
+}
+
+int ChannelProcessor::getMaxLatency() const {
+    const int longestDelay = (1 + ModelCache::getMaxLookaheadHops()) * frameLength;
+    return toHostLatency(longestDelay + juce::jmax(asyncWorker->getMaxAddedLatency(), getSyncPrimeSamples()));
+}
+
+int ChannelProcessor::toHostLatency(int modelLatency) const {
+    switch (ratePath) {
+        case RatePath::native:    return modelLatency;
+        case RatePath::halfband:  return 2 * modelLatency + HalfbandResampler::getLatency();
+        // linear phase, so the filters' delay is known; a fraction of a sample remains
+        case RatePath::polyphase: return juce::roundToInt(modelLatency * (hostSampleRate / modelRate) + polyphase.getLatency());
+        case RatePath::resampled: break;
+    }
+    return juce::roundToInt(modelLatency * (hostSampleRate / modelRate)) + resamplerLatency;
+}
+
+void ChannelProcessor::release() {
+    asyncWorker->stop();
+    asyncActive = false;
+}
+
+void ChannelProcessor::reset(Role newRole, StereoLink* newLink, bool async, bool offline) {
+    jassert(asyncWorker->isParked());
+    role = newRole;
+    link = newLink;
+    asyncActive = async || offline;
+
+    inputFifo.reset();
+    outputFifo.reset();
+    gate.reset();
+    lastSkipGain = juce::Decibels::decibelsToGain(-juce::jmax(0.0f, appliedAttenLim), -120.0f);
+    // a bounce has no deadline
+    nonModelMs = 0.0;
+    governor.reset(!governorEnabled || offline ? 0.0 : getHopBudgetMs());
+    if (asyncActive) {
+        asyncWorker->activate(offline ? AsyncInferenceWorker::Priming::offline
+                            : latencyMode == LatencyMode::low ? AsyncInferenceWorker::Priming::low
+                                                              : AsyncInferenceWorker::Priming::safe);
+    } else {
+        // a hop completes as soon as its last sample arrives, so at most one hop less a sample
+        // is ever waiting, whatever the block sizes
+        const int prime = getSyncPrimeSamples();
+        std::fill_n(outputFifo.writeSpan(prime), prime, 0.0f);
+        outputFifo.commit(prime);
+    }
+}
+
+void ChannelProcessor::process(float* data, int numSamples) {
+    // sync, the model shares the block's deadline with the resampling and FIFOs around it
+    const bool measure = !asyncActive && governor.isEnabled();
+    const auto startTicks = measure ? juce::Time::getHighResolutionTicks() : 0;
+    if (measure) modelMs = 0.0;
+    switch (ratePath) {
+        case RatePath::native:    processAtRate<RatePath::native>(data, numSamples); break;
+        case RatePath::halfband:  processAtRate<RatePath::halfband>(data, numSamples); break;
+        case RatePath::polyphase: processAtRate<RatePath::polyphase>(data, numSamples); break;
+        case RatePath::resampled: processAtRate<RatePath::resampled>(data, numSamples); break;
+    }
+    if (measure)
+        noteNonModelWork(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0 - modelMs);
+}
+
+double ChannelProcessor::getHopBudgetMs() const {
+    const double hopMs = 1000.0 * frameLength / modelRate;
+    if (asyncActive) return hopMs - nonModelMs;
+    // small blocks: the hop's period is spread over the blocks it spans, though one of them
+    // runs the model; large ones: the hops a block completes share it. Either way a
+    // double-buffered driver absorbs one block running late
+    const double spanMs = juce::jmax(hopMs, blockMs);
+    return (spanMs / blockMs * (blockMs - nonModelMs) + blockMs) / maxHopsPerBlock;
+}
+
+void ChannelProcessor::noteNonModelWork(double ms) {
+    // up at once, down slowly: the deadline is missed by the slow blocks, not the average
+    nonModelMs = ms > nonModelMs ? ms : nonModelMs + 0.02 * (ms - nonModelMs);
+    governor.setBudget(getHopBudgetMs());
+}
+
+template <ChannelProcessor::RatePath path>
+void ChannelProcessor::processAtRate(float* data, int numSamples) {
+    if constexpr (path == RatePath::native) {
+        // host buffer straight into the frame FIFO and back, in place
+        processAtModelRate(data, data, numSamples);
+    } else if constexpr (path == RatePath::halfband || path == RatePath::polyphase) {
+        juce::int64 start = recorder != nullptr ? FlightRecorder::now() : 0;
+        int numModelSamples;
+        if constexpr (path == RatePath::halfband)
+            numModelSamples = halfband.decimate(data, resampleInBuffer.data(), numSamples);
+        else
+            numModelSamples = polyphase.toModelRate(data, resampleInBuffer.data(), numSamples);
+        if (recorder != nullptr)
+            recorder->span(FlightRecorder::Type::toModel, start, telemetryChannel, (float)numSamples, (float)numModelSamples);
+        processAtModelRate(resampleInBuffer.data(), resampleOutBuffer.data(), numModelSamples);
+        start = recorder != nullptr ? FlightRecorder::now() : 0;
+        if constexpr (path == RatePath::halfband)
+            halfband.interpolate(resampleOutBuffer.data(), numModelSamples, data, numSamples);
+        else
+            polyphase.fromModelRate(resampleOutBuffer.data(), numModelSamples, data, numSamples);
+        if (recorder != nullptr)
+            recorder->span(FlightRecorder::Type::fromModel, start, telemetryChannel, (float)numModelSamples, (float)numSamples);
+        if (telemetry != nullptr)
+            telemetry->recordResampler(numSamples, numModelSamples);
+    } else {
+        // the model's work runs inside the resampler's callback, the span covers both
+        const juce::int64 start = recorder != nullptr ? FlightRecorder::now() : 0;
+        float* sourceInputPtrs[] = { data };                    float* sourceOutputPtrs[] = { data };
+        float* targetInputPtrs[] = { resampleInBuffer.data() }; float* targetOutputPtrs[] = { resampleOutBuffer.data() };
+        int numModelSamples = 0;
+        resamplerHandler->process(
+            sourceInputPtrs,
+            sourceOutputPtrs,
+            targetInputPtrs,
+            targetOutputPtrs,
+            numSamples,
+            // lambda callback
+            [this, &numModelSamples](float* const* input_buffers, float* const* output_buffers, int sample_count) {
+                processAtModelRate(input_buffers[0], output_buffers[0], sample_count);
+                numModelSamples += sample_count;
+            }
+        );
+        if (recorder != nullptr)
+            recorder->span(FlightRecorder::Type::resample, start, telemetryChannel, (float)numSamples, (float)numModelSamples);
+        if (telemetry != nullptr)
+            telemetry->recordResampler(numSamples, numModelSamples);
+    }
+}
+
+void ChannelProcessor::processAtModelRate(const float* readPtr, float* writePtr, int numSamples) {
+    // async: inference runs on the worker thread
+    if (asyncActive) {
+        if (!asyncWorker->push(readPtr, numSamples)) {
+            if (telemetry != nullptr) telemetry->recordOverflow();
+            if (recorder != nullptr) recorder->mark(FlightRecorder::Type::overflow, telemetryChannel, (float)numSamples);
+        }
+        // the worker's output is primed, so any padding is a late frame
+        bool complete = asyncWorker->pull(writePtr, numSamples);
+        if (!complete) governor.noteUnderrun();
+        if (telemetry != nullptr) {
+            telemetry->recordFill(telemetryChannel, asyncWorker->getInputFill(), asyncWorker->getOutputFill());
+            if (!complete) telemetry->recordUnderrun();
+        }
+        if (recorder != nullptr) {
+            recorder->mark(FlightRecorder::Type::fifo, telemetryChannel, (float)asyncWorker->getInputFill(), (float)asyncWorker->getOutputFill());
+            if (!complete) recorder->mark(FlightRecorder::Type::underrun, telemetryChannel);
+        }
+        return;
+    }
+
+    // a full FIFO means a block above samplesPerBlock or frames not being consumed; drop the
+    // block rather than corrupt the stream, the output runs short and is counted as an underrun
+    if (!inputFifo.write(readPtr, numSamples)) {
+        if (telemetry != nullptr) telemetry->recordOverflow();
+        if (recorder != nullptr) recorder->mark(FlightRecorder::Type::overflow, telemetryChannel, (float)numSamples);
+    }
+
+    // predict, straight from input ring memory into output ring memory, as many hops per call as are ready
+    for (;;) {
+        int numFrames = juce::jmin(inputFifo.getNumReady() / frameLength, outputFifo.getFreeSpace() / frameLength,
+                                   (int)maxFrames);
+        numFrames = getNumFramesReady(numFrames);
+        if (numFrames <= 0) break;
+
+        const int numSamples = numFrames * frameLength;
+        processFrames(inputFifo.readSpan(numSamples), outputFifo.writeSpan(numSamples), numFrames);
+        inputFifo.discard(numSamples);
+        outputFifo.commit(numSamples);
+    }
+    // outputfifo ---> writePtr; primed in reset(), so only zero-padded if something went wrong
+    bool complete = outputFifo.read(writePtr, numSamples) == numSamples;
+    if (telemetry != nullptr) {
+        telemetry->recordFill(telemetryChannel, inputFifo.getNumReady(), outputFifo.getNumReady());
+        if (!complete) telemetry->recordUnderrun();
+    }
+    if (recorder != nullptr) {
+        recorder->mark(FlightRecorder::Type::fifo, telemetryChannel, (float)inputFifo.getNumReady(), (float)outputFifo.getNumReady());
+        if (!complete) recorder->mark(FlightRecorder::Type::underrun, telemetryChannel);
+    }
+}
+
+int ChannelProcessor::getNumFramesReady(int wanted) const {
+    return role == Role::linkedSide ? juce::jmin(wanted, link->getNumGains()) : wanted;
+}
+
+void ChannelProcessor::processFrames(const float* input, float* output, int numFrames) {
+    if (role == Role::linkedSide) {
+        for (int i = 0; i < numFrames; ++i)
+            link->applyGain(input + i * frameLength, output + i * frameLength);
+        return;
+    }
+
+    const float target = targetAttenLim.load();
+    if (target != rampTarget) {
+        rampTarget = target;
+        rampStep = std::abs(target - appliedAttenLim) / (float)attenLimRampHops;
+    }
+
+    // async, the worker's own work around the model is timed here instead
+    const bool measure = asyncActive && governor.isEnabled();
+    const auto startTicks = measure ? juce::Time::getHighResolutionTicks() : 0;
+    if (measure) modelMs = 0.0;
+
+    // hops come in runs straight from ring memory, but go to the model one by one, so the
+    // gate always decides on the LSNR of the hop before
+    const bool gateOn = gateEnabled.load();
+    const float floor = gateFloor.load();
+    float bypassGain = juce::Decibels::decibelsToGain(-appliedAttenLim, -120.0f);
+    std::array<int, LoadGovernor::numCounters> tierHops {};
+    for (int i = 0; i < numFrames; ++i) {
+        const float* in = input + i * frameLength;
+        float* out = output + i * frameLength;
+        if (appliedAttenLim != rampTarget) {
+            stepAttenLim();
+            bypassGain = juce::Decibels::decibelsToGain(-appliedAttenLim, -120.0f);
+        }
+        // under CPU pressure the gate is opened less readily, or held shut
+        const bool probe = governor.beginHop();
+        const auto tier = governor.getTier();
+        auto action = gate.analyse(in, gateOn || tier != LoadGovernor::Tier::full,
+                                   tier == LoadGovernor::Tier::full ? floor : floor + LoadGovernor::eagerGateBoostDb,
+                                   tier == LoadGovernor::Tier::fallback);
+        const float energyDb = gate.getLastEnergyDb();
+        if (tier != LoadGovernor::Tier::fallback)
+            ++tierHops[(size_t)(tier == LoadGovernor::Tier::full ? LoadGovernor::Counter::full : LoadGovernor::Counter::eagerGate)];
+        if (action == FrameGate::Action::infer) {
+            inferFrame(in, out, energyDb);
+            continue;
+        }
+
+        // a hop without the model: at the attenuation limit if the gate found it quiet,
+        // at the governor's fallback gain if there is no CPU for it
+        float skipGain = bypassGain;
+        if (tier == LoadGovernor::Tier::fallback) {
+            auto used = LoadGovernor::Counter::heldGain;
+            skipGain = governor.getFallbackGain(energyDb, gate.getNoiseDb(), bypassGain, used);
+            ++tierHops[(size_t)used];
+        }
+
+        if (action == FrameGate::Action::skip) {
+            gate.writeBypass(out, skipGain, lastSkipGain);
+            lastSkipGain = skipGain;
+            if (probe) probeModel(in);
+            if (tier != LoadGovernor::Tier::fallback)
+                skippedFrames.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        // catch the model up on what it missed, so its lookahead is valid again
+        if (action == FrameGate::Action::open) {
+            const auto prerollStart = juce::Time::getHighResolutionTicks();
+            for (int p = 0; p < gate.getNumPrerollFrames(); ++p)
+                dfProcessor->processFrame(gate.getPrerollFrame(p), prerollOutput.data());
+            modelMs += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - prerollStart) * 1000.0;
+            inferredFrames.fetch_add((juce::uint64)gate.getNumPrerollFrames(), std::memory_order_relaxed);
+        }
+        inferFrame(in, out, energyDb);
+        if (action == FrameGate::Action::open) {
+            gate.crossfade(out, lastSkipGain, true);
+        } else {
+            gate.crossfade(out, skipGain, false);
+            lastSkipGain = skipGain;
+        }
+    }
+
+    if (measure)
+        noteNonModelWork((juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0 - modelMs) / numFrames);
+
+    for (int c = 0; c < LoadGovernor::numCounters; ++c) {
+        if (tierHops[(size_t)c] == 0) continue;
+        governor.count((LoadGovernor::Counter)c, tierHops[(size_t)c]);
+        if (telemetry != nullptr)
+            telemetry->recordTierHops(c, tierHops[(size_t)c]);
+    }
+
+    if (role == Role::linkedMid)
+        for (int i = 0; i < numFrames; ++i)
+            if (!link->publishGain(input + i * frameLength, output + i * frameLength)) {
+                if (telemetry != nullptr) telemetry->recordOverflow();
+                if (recorder != nullptr) recorder->mark(FlightRecorder::Type::overflow, telemetryChannel, (float)frameLength);
+            }
+}
+
+void ChannelProcessor::stepAttenLim() {
+    if (appliedAttenLim < 0.0f)
+        appliedAttenLim = rampTarget;
+    else if (appliedAttenLim < rampTarget)
+        appliedAttenLim = juce::jmin(rampTarget, appliedAttenLim + rampStep);
+    else
+        appliedAttenLim = juce::jmax(rampTarget, appliedAttenLim - rampStep);
+    dfProcessor->setAttenLim(appliedAttenLim);
+}
+
+void ChannelProcessor::inferFrame(const float* input, float* output, float energyDb) {
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    const float lsnr = dfProcessor->processFrame(input, output);
+    auto endTicks = juce::Time::getHighResolutionTicks();
+    double ms = juce::Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1000.0;
+    modelMs += ms;
+    if (recorder != nullptr)
+        recorder->span(FlightRecorder::Type::inference, startTicks, endTicks, telemetryChannel, 1.0f);
+    if (telemetry != nullptr)
+        telemetry->recordInference(ms, 1);
+    governor.recordInference(ms);
+    gate.inferred(lsnr, energyDb);
+    // the model's broadband gain, what the governor falls back to first
+    if (governor.isEnabled()) {
+        float outEnergy = 0.0f;
+        for (int n = 0; n < frameLength; ++n)
+            outEnergy += output[n] * output[n];
+        governor.recordGain(std::pow(10.0f, 0.1f * energyDb), outEnergy / (float)frameLength);
+    }
+    inferredFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ChannelProcessor::probeModel(const float* input) {
+    // keeps the model's state moving and tells the governor what a hop costs now; the output
+    // is not used, the model has been missing hops
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    dfProcessor->processFrame(input, prerollOutput.data());
+    auto endTicks = juce::Time::getHighResolutionTicks();
+    const double ms = juce::Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1000.0;
+    modelMs += ms;
+    governor.recordInference(ms);
+    if (recorder != nullptr)
+        recorder->span(FlightRecorder::Type::inference, startTicks, endTicks, telemetryChannel, 1.0f);
+    inferredFrames.fetch_add(1, std::memory_order_relaxed);
+}
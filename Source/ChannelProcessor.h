@@ -0,0 +1,156 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "DeepFilterNetProcessor.h"
+#include "AsyncInferenceWorker.h"
+#include "StereoLink.h"
+#include "FrameGate.h"
+#include "LoadGovernor.h"
+#include "RingBuffer.h"
+#include "HalfbandResampler.h"
+#include "PolyphaseResampler.h"
+#include "Telemetry.h"
+#include "FlightRecorder.h"
+#include "Resampler.hpp"
+#include <vector>
+#include <memory>
+
+// Everything one channel needs: its own model state, resampler, FIFOs and async worker.
+class ChannelProcessor : public FrameProcessor {
+public:
+    enum class Role { independent, linkedMid, linkedSide };
+    // how host audio reaches the model's rate, picked once in prepare()
+    enum class RatePath { native, halfband, polyphase, resampled };
+    // how much slack the async worker gets; the sync path is always primed to the minimum
+    enum class LatencyMode { low, safe };
+
+    ChannelProcessor();
+    ~ChannelProcessor() override;
+
+    // background thread: loads a model variant, adopted by prepare() or adoptPendingModel()
+    bool initialize(int variant = ModelCache::defaultVariant);
+    bool isReady() const { return dfProcessor->isReady(); }
+    // a loaded model adoptPendingModel() can switch to, i.e. one trained at the prepared rate
+    bool hasPendingModel() const { return dfProcessor->hasPending(modelRate); }
+    // a loaded model at another rate, which only the next prepare() can switch to
+    bool needsPrepareForModel() const { return dfProcessor->hasPending() && !hasPendingModel(); }
+    int getLoadedModelVariant() const { return dfProcessor->getLoadedVariant(); }
+    // audio thread, only while the worker is parked: switches to the loaded model, call reset() after
+    void adoptPendingModel();
+
+    // not real-time safe; offline users pass withAsyncWorker = false
+    void prepare(double sampleRate, int samplesPerBlock, bool withAsyncWorker = true);
+    void release();
+
+    // audio thread, only while the worker is parked; offline implies async with blocking pulls
+    void reset(Role newRole, StereoLink* newLink, bool async, bool offline = false);
+    // takes effect on the next reset(), no reload needed
+    void setLatencyMode(LatencyMode newMode) { latencyMode = newMode; }
+    AsyncInferenceWorker& getWorker() { return *asyncWorker; }
+    int getFrameLength() const { return frameLength; }
+    int getModelDelay() const { return dfProcessor->getModelDelay(); }
+    // most hops that can sit between input and inference, in either mode; after prepare()
+    int getMaxBacklogHops() const { return juce::jmax(asyncWorker->getCapacity(), inputFifo.getCapacity()) / frameLength + maxFrames; }
+    RatePath getRatePath() const { return ratePath; }
+    int getModelSampleRate() const { return modelRate; }
+    // exact delay from input to output at the host rate, for the current path and mode
+    int getLatency() const;
+    // the longest getLatency() can get, over every variant and mode at this rate; after prepare()
+    int getMaxLatency() const;
+
+    // any thread; the model follows along a ramp of attenLimRampHops hops, one step per hop
+    void setAttenLim(float limitDB) { targetAttenLim.store(limitDB); }
+    // skip inference on hops below floorDB (dBFS) or that the model called noise
+    void setGate(bool enabled, float floorDB) { gateEnabled.store(enabled); gateFloor.store(floorDB); }
+
+    // hops that ran the model (pre-roll included) and hops the gate skipped
+    juce::uint64 getInferredFrameCount() const { return inferredFrames.load(); }
+    juce::uint64 getSkippedFrameCount() const { return skippedFrames.load(); }
+
+    // lets the channel degrade instead of dropping out when inference misses its deadline;
+    // off by default, offline renders never degrade. Takes effect on the next reset().
+    // The budget is the host time the hop spans, less the measured work around the model
+    void setLoadGovernorEnabled(bool enabled) { governorEnabled = enabled; }
+    // any thread: the host block this channel ran in overran its deadline
+    void noteOverrun() { governor.noteUnderrun(); }
+    juce::uint64 getTierHopCount(LoadGovernor::Counter counter) const { return governor.getCount(counter); }
+
+    // while stopped; reports into telemetry under the given channel index, nullptr for none
+    void setTelemetry(Telemetry* newTelemetry, int channelIndex) { telemetry = newTelemetry; telemetryChannel = channelIndex; }
+    // while stopped; resampler passes, inference runs and FIFO levels go into it, nullptr for none
+    void setFlightRecorder(FlightRecorder* newRecorder) { recorder = newRecorder; }
+
+    // host sample rate, in place
+    void process(float* data, int numSamples);
+
+    // FrameProcessor: runs on the audio thread, or on the worker in async mode
+    int getNumFramesReady(int wanted) const override;
+    void processFrames(const float* input, float* output, int numFrames) override;
+
+private:
+    template <RatePath path>
+    void processAtRate(float* data, int numSamples);
+    void inferFrame(const float* input, float* output, float energyDb);
+    void processAtModelRate(const float* input, float* output, int numSamples);
+    int getSyncPrimeSamples() const { return frameLength - 1; }
+    // model-rate samples -> host-rate samples, through the current rate path
+    int toHostLatency(int modelLatency) const;
+    // moves the applied limit one step towards the target, at a hop boundary
+    void stepAttenLim();
+    // one hop through the model for the governor to time, output discarded
+    void probeModel(const float* input);
+    // what one hop may cost: sync, its share of the host blocks it spans once the work around
+    // the model is done, plus the driver's slack; async, the worker only has to keep up
+    double getHopBudgetMs() const;
+    // ms spent outside the model, per block on the sync path, per hop on the async one
+    void noteNonModelWork(double ms);
+
+    static constexpr int attenLimRampHops = 5; // 50 ms
+
+    std::unique_ptr<DeepFilterNetProcessor> dfProcessor;
+    std::unique_ptr<AsyncInferenceWorker> asyncWorker;
+
+    Role role = Role::independent;
+    StereoLink* link = nullptr;
+    bool asyncActive = false;
+    LatencyMode latencyMode = LatencyMode::safe;
+    int frameLength = 480;
+    int modelRate = 48000;
+    double hostSampleRate = 48000.0;
+
+    std::atomic<float> targetAttenLim { 100.0f };
+    float appliedAttenLim = -1.0f; // -1: the state's limit is unknown, jump straight to the target
+    float rampTarget = -1.0f;
+    float rampStep = 0.0f;
+
+    FrameGate gate;
+    LoadGovernor governor;
+    bool governorEnabled = false;
+    double blockMs = 0.0;     // the host's deadline, from prepare()
+    int maxHopsPerBlock = 1;  // the most hops one host block can complete
+    double modelMs = 0.0;     // inference time since the current measurement started
+    double nonModelMs = 0.0;  // see noteNonModelWork()
+    float lastSkipGain = 1.0f; // what the last hop without the model was scaled by
+    std::atomic<bool> gateEnabled { true };
+    std::atomic<float> gateFloor { -60.0f };
+    std::vector<float> prerollOutput;
+    std::atomic<juce::uint64> inferredFrames { 0 };
+    std::atomic<juce::uint64> skippedFrames { 0 };
+
+    RingBuffer inputFifo;
+    RingBuffer outputFifo;
+
+    Telemetry* telemetry = nullptr;
+    int telemetryChannel = 0;
+    FlightRecorder* recorder = nullptr;
+
+    RatePath ratePath = RatePath::resampled;
+    HalfbandResampler halfband;
+    PolyphaseResampler polyphase;
+    std::unique_ptr<Resampler<1, 1>> resamplerHandler;
+    int resamplerLatency = 0; // round trip through resamplerHandler, host samples
+    std::vector<float> resampleInBuffer;
+    std::vector<float> resampleOutBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelProcessor)
+};
@@ -0,0 +1,93 @@
+#include "ChannelThreadPool.h"
+#include "WakeSemaphore.h"
+#include <thread>
+
+class ChannelThreadPool::Helper : public juce::Thread {
+public:
+    explicit Helper(ChannelThreadPool& p) : juce::Thread("Alt Denoiser Channel"), pool(p) {}
+    ~Helper() override {
+        signalThreadShouldExit();
+        wakeup.signal(1);
+        stopThread(2000);
+    }
+
+    // audio thread, real-time safe
+    void wake() { wakeup.notify(); }
+
+    void run() override {
+        while (!threadShouldExit()) {
+            wakeup.wait(-1);
+            if (!threadShouldExit())
+                pool.join();
+        }
+    }
+
+private:
+    ChannelThreadPool& pool;
+    WakeSemaphore wakeup;
+};
+
+ChannelThreadPool::ChannelThreadPool() {
+}
+
+ChannelThreadPool::~ChannelThreadPool() {
+    release();
+}
+
+void ChannelThreadPool::prepare(int numHelpers) {
+    numHelpers = juce::jlimit(0, juce::jmax(0, juce::SystemStats::getNumCpus() - 1), numHelpers);
+    if ((int)helpers.size() == numHelpers) return;
+
+    release();
+    for (int i = 0; i < numHelpers; ++i) {
+        helpers.push_back(std::make_unique<Helper>(*this));
+        helpers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(8));
+    }
+}
+
+void ChannelThreadPool::release() {
+    helpers.clear();
+}
+
+void ChannelThreadPool::join() {
+    int count = joined.load(std::memory_order_relaxed);
+    do {
+        if (count & closedFlag) return; // woke after the block was done
+    } while (!joined.compare_exchange_weak(count, count + 1, std::memory_order_acquire, std::memory_order_relaxed));
+    runJobs();
+    joined.fetch_sub(1, std::memory_order_release);
+}
+
+void ChannelThreadPool::runJobs() {
+    for (int index = nextJob.fetch_add(1); index < currentNumJobs; index = nextJob.fetch_add(1))
+        currentJob(currentContext, index);
+}
+
+void ChannelThreadPool::run(Job job, void* context, int numJobs) {
+    int numHelpers = juce::jmin((int)helpers.size(), numJobs - 1);
+    if (numHelpers <= 0) {
+        for (int i = 0; i < numJobs; ++i)
+            job(context, i);
+        return;
+    }
+
+    currentJob = job;
+    currentContext = context;
+    currentNumJobs = numJobs;
+    nextJob.store(0);
+    // open before waking, so a helper that wakes sees this block's job
+    joined.store(0, std::memory_order_release);
+
+    for (int i = 0; i < numHelpers; ++i)
+        helpers[i]->wake();
+
+    runJobs();
+
+    // every job has been claimed; close the block and wait for the helpers still running
+    // theirs, so none can straddle into the next one. Helpers that never woke aren't waited for
+    int count = joined.fetch_or(closedFlag, std::memory_order_acq_rel);
+    while ((count & ~closedFlag) > 0) {
+        std::this_thread::yield();
+        count = joined.load(std::memory_order_acquire);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Small fork-join pool used to run the channels of one block in parallel.
+// The calling (audio) thread takes part in the work and returns once every job is done,
+// so nothing is allocated or queued per block. Helpers sleep on a WakeSemaphore between
+// blocks. One that wakes too late to be useful finds the block closed and goes back to
+// sleep; the audio thread only ever waits for helpers that joined in time, which are
+// running a job, not asleep.
+class ChannelThreadPool {
+public:
+    using Job = void (*)(void* context, int index);
+
+    ChannelThreadPool();
+    ~ChannelThreadPool();
+
+    // not real-time safe: starts or stops helper threads
+    void prepare(int numHelpers);
+    void release();
+
+    void run(Job job, void* context, int numJobs);
+
+private:
+    class Helper;
+
+    // helper thread: takes part in the current block, unless it is already closed
+    void join();
+    void runJobs();
+
+    std::vector<std::unique_ptr<Helper>> helpers;
+
+    Job currentJob = nullptr;
+    void* currentContext = nullptr;
+    int currentNumJobs = 0;
+    std::atomic<int> nextJob { 0 };
+    // helpers inside the current block, plus closedFlag once the audio thread stops taking them
+    std::atomic<int> joined { closedFlag };
+    static constexpr int closedFlag = 1 << 30;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelThreadPool)
+};
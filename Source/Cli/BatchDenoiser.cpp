@@ -0,0 +1,166 @@
+#include "BatchDenoiser.h"
+#include <algorithm>
+#include <cstdio>
+
+class BatchDenoiser::Worker : public juce::Thread {
+public:
+    Worker(BatchDenoiser& o, int index)
+        : juce::Thread("Alt Denoiser Batch " + juce::String(index)), owner(o) {}
+    ~Worker() override { stopThread(-1); }
+
+    void run() override {
+        while (!threadShouldExit()) {
+            auto* job = owner.nextJob();
+            if (job == nullptr) break;
+            if (!processFile(*job))
+                ++owner.numFailed;
+        }
+    }
+
+private:
+    static constexpr int blockSize = 4096;
+
+    bool fail(const Job& job, const juce::String& reason) {
+        owner.report(0.0, job.input.getFileName() + ": " + reason);
+        return false;
+    }
+
+    // one model state per channel, kept for the next file
+    bool ensureChannels(int numChannels) {
+        while ((int)channels.size() < numChannels) {
+            channels.push_back(std::make_unique<ChannelProcessor>());
+            if (!channels.back()->initialize(owner.options.modelVariant)) return false;
+        }
+        return true;
+    }
+
+    bool processFile(const Job& job) {
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(owner.formatManager.createReaderFor(job.input));
+        if (reader == nullptr) return fail(job, "unsupported or unreadable file");
+
+        const int numChannels = (int)reader->numChannels;
+        const double sampleRate = reader->sampleRate;
+        const juce::int64 length = reader->lengthInSamples;
+        if (numChannels <= 0 || sampleRate <= 0.0) return fail(job, "no audio");
+        if (!ensureChannels(numChannels)) return fail(job, "model failed to load");
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            channels[ch]->prepare(sampleRate, blockSize, false);
+            channels[ch]->reset(ChannelProcessor::Role::independent, nullptr, false);
+            channels[ch]->setAttenLim(owner.options.attenLim);
+        }
+        const int latency = channels[0]->getLatency();
+
+        // same format as the input, written next to it and swapped in once complete
+        auto outputFile = owner.getOutputFile(job.input);
+        auto* format = owner.formatManager.findFormatForFileExtension(outputFile.getFileExtension());
+        if (format == nullptr) return fail(job, "no writer for " + outputFile.getFileExtension());
+
+        int bitDepth = (int)reader->bitsPerSample;
+        if (!format->getPossibleBitDepths().contains(bitDepth))
+            bitDepth = 24;
+
+        juce::TemporaryFile tempFile(outputFile);
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        {
+            auto stream = tempFile.getFile().createOutputStream();
+            if (stream == nullptr) return fail(job, "can't write " + outputFile.getFullPathName());
+            writer.reset(format->createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels,
+                                                 bitDepth, reader->metadataValues, 0));
+            if (writer == nullptr) return fail(job, "can't write this format");
+            stream.release(); // owned by the writer now
+        }
+
+        // stream through; reading past the end yields zeros, which flush the model's tail
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::int64 readPos = 0;
+        juce::int64 written = 0;
+        juce::int64 toSkip = latency;
+        while (written < length && !threadShouldExit()) {
+            int numSamples = (int)juce::jmin<juce::int64>(blockSize, length + latency - readPos);
+            reader->read(&buffer, 0, numSamples, readPos, true, true);
+            readPos += numSamples;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                channels[ch]->process(buffer.getWritePointer(ch), numSamples);
+
+            // drop the latency so the output lines up with the input
+            int skip = (int)juce::jmin<juce::int64>(toSkip, numSamples);
+            toSkip -= skip;
+            int numOut = (int)juce::jmin<juce::int64>(numSamples - skip, length - written);
+            if (numOut > 0 && !writer->writeFromAudioSampleBuffer(buffer, skip, numOut))
+                return fail(job, "write error");
+            written += juce::jmax(0, numOut);
+        }
+        writer.reset();
+        if (threadShouldExit()) return false;
+        if (!tempFile.overwriteTargetFileWithTemporary()) return fail(job, "can't replace " + outputFile.getFullPathName());
+
+        double seconds = (double)length / sampleRate;
+        double elapsed = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        owner.report(seconds, juce::String::formatted("%-40s %9.1f s  %7.1fxRT", job.input.getFileName().toRawUTF8(),
+                                             seconds, seconds / juce::jmax(elapsed, 1.0e-6)));
+        return true;
+    }
+
+    BatchDenoiser& owner;
+    std::vector<std::unique_ptr<ChannelProcessor>> channels;
+};
+
+BatchDenoiser::BatchDenoiser(const Options& o) : options(o) {
+    formatManager.registerBasicFormats();
+}
+
+BatchDenoiser::~BatchDenoiser() {
+}
+
+bool BatchDenoiser::run(const juce::Array<juce::File>& files) {
+    jobs.clear();
+    for (const auto& file : files)
+        jobs.push_back({ file, file.getSize() });
+    // longest first, so the pool doesn't finish on one big file
+    std::sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.size > b.size; });
+    nextJobIndex = 0;
+    numFailed = 0;
+    totalAudioSeconds = 0.0; // no workers yet
+
+    int numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    numThreads = juce::jlimit(1, juce::jmax(1, (int)jobs.size()), numThreads);
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < numThreads; ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->startThread();
+    }
+    for (auto& worker : workers)
+        worker->waitForThreadToExit(-1);
+    workers.clear();
+
+    double elapsed = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    double audio = totalAudioSeconds;
+    std::printf("%d files, %.1f s of audio in %.1f s on %d threads: %.1fxRT overall",
+                (int)jobs.size(), audio, elapsed, numThreads, audio / juce::jmax(elapsed, 1.0e-6));
+    if (numFailed > 0) std::printf(", %d failed", numFailed.load());
+    std::printf("\n");
+    return numFailed == 0;
+}
+
+const BatchDenoiser::Job* BatchDenoiser::nextJob() {
+    int index = nextJobIndex.fetch_add(1);
+    return index < (int)jobs.size() ? &jobs[(size_t)index] : nullptr;
+}
+
+void BatchDenoiser::report(double audioSeconds, const juce::String& line) {
+    const juce::ScopedLock sl(reportLock);
+    totalAudioSeconds += audioSeconds;
+    std::printf("%s\n", line.toRawUTF8());
+    std::fflush(stdout);
+}
+
+juce::File BatchDenoiser::getOutputFile(const juce::File& input) const {
+    auto dir = options.outputDir != juce::File() ? options.outputDir : input.getParentDirectory();
+    return dir.getChildFile(input.getFileNameWithoutExtension() + options.suffix + input.getFileExtension());
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "ChannelProcessor.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Runs a list of files through the model on a pool of worker threads.
+// Files are handed out largest first from a shared cursor, so a worker that finishes
+// early simply takes the next one and the long files don't all end up at the back.
+class BatchDenoiser {
+public:
+    struct Options {
+        int numThreads = 0; // 0 = one per core
+        float attenLim = 100.0f;
+        int modelVariant = ModelCache::defaultVariant;
+        juce::File outputDir; // empty = next to the input
+        juce::String suffix = "_denoised";
+    };
+
+    explicit BatchDenoiser(const Options& options);
+    ~BatchDenoiser();
+
+    // blocks until every file is done; false if any of them failed
+    bool run(const juce::Array<juce::File>& files);
+
+private:
+    class Worker;
+
+    struct Job {
+        juce::File input;
+        juce::int64 size = 0;
+    };
+
+    // any worker thread
+    const Job* nextJob();
+    // prints one line and adds the file's duration to the total
+    void report(double audioSeconds, const juce::String& line);
+    juce::File getOutputFile(const juce::File& input) const;
+
+    Options options;
+    juce::AudioFormatManager formatManager;
+
+    std::vector<Job> jobs;
+    std::atomic<int> nextJobIndex { 0 };
+    std::atomic<int> numFailed { 0 };
+    juce::CriticalSection reportLock;
+    double totalAudioSeconds = 0.0; // guarded by reportLock
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchDenoiser)
+};
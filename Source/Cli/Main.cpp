@@ -0,0 +1,76 @@
+// alt-denoiser-cli: denoises WAV/FLAC files offline, many files at once.
+//
+//   alt-denoiser-cli [-j threads] [-a attenDb] [-m model] [-o outDir] [-s suffix] <file|dir>...
+//
+// Files are streamed block by block, so memory use does not depend on their length.
+// Each worker thread owns its own model states and takes the next file when it is done.
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "BatchDenoiser.h"
+#include <cstdio>
+
+namespace {
+    void printUsage() {
+        std::printf("usage: alt-denoiser-cli [options] <file|dir>...\n"
+                    "  -j <n>       worker threads (default: number of cores)\n"
+                    "  -a <dB>      attenuation limit, 0-100 (default: 100)\n"
+                    "  -m <model>   model variant (default: DeepFilterNet3)\n"
+                    "  -o <dir>     output folder (default: next to each input)\n"
+                    "  -s <suffix>  output file name suffix (default: _denoised)\n");
+    }
+
+    // by name, case-insensitive; -1 if unknown
+    int findModelVariant(const juce::String& name) {
+        for (int i = 0; i < ModelCache::numVariants; ++i)
+            if (name.equalsIgnoreCase(ModelCache::variants[(size_t)i].name)) return i;
+        return -1;
+    }
+
+    void addInputs(const juce::String& path, juce::Array<juce::File>& files) {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+        if (file.isDirectory()) {
+            for (const auto& entry : juce::RangedDirectoryIterator(file, true, "*.wav;*.flac", juce::File::findFiles))
+                files.add(entry.getFile());
+        } else if (file.existsAsFile()) {
+            files.add(file);
+        } else {
+            std::fprintf(stderr, "not found: %s\n", path.toRawUTF8());
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BatchDenoiser::Options options;
+    juce::Array<juce::File> files;
+
+    for (int i = 1; i < argc; ++i) {
+        juce::String arg(argv[i]);
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+        else if (arg == "-j" && hasValue) options.numThreads = juce::String(argv[++i]).getIntValue();
+        else if (arg == "-a" && hasValue) options.attenLim = juce::jlimit(0.0f, 100.0f, juce::String(argv[++i]).getFloatValue());
+        else if (arg == "-m" && hasValue) {
+            options.modelVariant = findModelVariant(argv[++i]);
+            if (options.modelVariant < 0) {
+                std::fprintf(stderr, "unknown model: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (arg == "-o" && hasValue) options.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "-s" && hasValue) options.suffix = argv[++i];
+        else if (arg.startsWith("-")) { printUsage(); return 1; }
+        else addInputs(arg, files);
+    }
+
+    if (files.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+    if (options.outputDir != juce::File() && !options.outputDir.createDirectory()) {
+        std::fprintf(stderr, "can't create %s\n", options.outputDir.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    BatchDenoiser denoiser(options);
+    return denoiser.run(files) ? 0 : 1;
+}
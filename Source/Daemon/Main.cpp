@@ -0,0 +1,71 @@
+// alt-denoiser-daemon: denoises live PCM streams for other processes, e.g. a voice gateway.
+//
+//   alt-denoiser-daemon [-j threads] [-n maxSessions] [-a attenDb] [-m model] [-i statsSeconds] <socket>
+//
+// Each connection to the Unix domain socket is one mono stream with its own model state;
+// see StreamServer.h for the protocol. Runs until SIGINT or SIGTERM.
+#include <juce_core/juce_core.h>
+#include "StreamServer.h"
+#include <csignal>
+#include <cstdio>
+
+namespace {
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void printUsage() {
+        std::printf("usage: alt-denoiser-daemon [options] <socket>\n"
+                    "  -j <n>       worker threads (default: number of cores)\n"
+                    "  -n <n>       most concurrent sessions (default: 512)\n"
+                    "  -a <dB>      attenuation limit, 0-100 (default: 100)\n"
+                    "  -m <model>   model variant (default: DeepFilterNet3)\n"
+                    "  -i <s>       per-session stats interval, 0 = on close only (default: 10)\n");
+    }
+
+    // by name, case-insensitive; -1 if unknown
+    int findModelVariant(const juce::String& name) {
+        for (int i = 0; i < ModelCache::numVariants; ++i)
+            if (name.equalsIgnoreCase(ModelCache::variants[(size_t)i].name)) return i;
+        return -1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    StreamServer::Options options;
+    juce::String socketPath;
+
+    for (int i = 1; i < argc; ++i) {
+        juce::String arg(argv[i]);
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+        else if (arg == "-j" && hasValue) options.numThreads = juce::String(argv[++i]).getIntValue();
+        else if (arg == "-n" && hasValue) options.maxSessions = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+        else if (arg == "-a" && hasValue) options.attenLim = juce::jlimit(0.0f, 100.0f, juce::String(argv[++i]).getFloatValue());
+        else if (arg == "-m" && hasValue) {
+            options.modelVariant = findModelVariant(argv[++i]);
+            if (options.modelVariant < 0) {
+                std::fprintf(stderr, "unknown model: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (arg == "-i" && hasValue) options.statsIntervalMs = juce::jmax(0, juce::roundToInt(juce::String(argv[++i]).getDoubleValue() * 1000.0));
+        else if (arg.startsWith("-") || socketPath.isNotEmpty()) { printUsage(); return 1; }
+        else socketPath = juce::File::getCurrentWorkingDirectory().getChildFile(arg).getFullPathName();
+    }
+
+    if (socketPath.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    // a client that hangs up mid-write must not take the daemon down
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, [](int) { stopRequested = 1; });
+    std::signal(SIGTERM, [](int) { stopRequested = 1; });
+
+    StreamServer server(options);
+    if (!server.start(socketPath)) return 1;
+    while (stopRequested == 0)
+        juce::Thread::sleep(100);
+    server.stop();
+    return 0;
+}
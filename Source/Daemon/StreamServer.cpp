@@ -0,0 +1,448 @@
+#include "StreamServer.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+ #define MSG_NOSIGNAL 0 // macOS: SIGPIPE is ignored process-wide instead
+#endif
+
+namespace {
+    bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    // best effort, for the short replies sent before a session is handed over
+    void sendLine(int fd, const juce::String& line) {
+        auto text = line + "\n";
+        auto written = ::send(fd, text.toRawUTF8(), text.getNumBytesAsUTF8(), MSG_NOSIGNAL);
+        juce::ignoreUnused(written);
+    }
+}
+
+//==============================================================================
+class StreamServer::Session {
+public:
+    enum class Format { s16, f32 };
+
+    Session(int socket, int sessionId) : fd(socket), id(sessionId) {}
+    ~Session() { if (fd >= 0) ::close(fd); }
+
+    // loader thread: the slow part, so neither the acceptor nor a worker waits for df_create
+    bool initialize(const Options& options) {
+        channel = std::make_unique<ChannelProcessor>();
+        if (!channel->initialize(options.modelVariant)) return false;
+        channel->setAttenLim(options.attenLim);
+        return true;
+    }
+
+    int getFd() const { return fd; }
+    int getId() const { return id; }
+    bool isFinished() const { return finished; }
+    // the client isn't reading: stop reading from it too, until the backlog has gone out
+    bool wantsInput() const { return !inputClosed && outBytes.size() - outPos < maxBacklogBytes; }
+    bool wantsOutput() const { return outPos < outBytes.size(); }
+
+    // worker thread
+    void onReadable() {
+        if (inputClosed) return;
+        char chunk[16384];
+        for (;;) {
+            auto n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                if (!consume(chunk, (size_t)n)) { finished = true; return; }
+                if (!wantsInput()) return;
+                continue;
+            }
+            if (n == 0) {
+                inputClosed = true;
+                if (prepared) flushTail();
+                if (!wantsOutput()) finished = true;
+                return;
+            }
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) finished = true;
+            return;
+        }
+    }
+
+    void onWritable() {
+        while (outPos < outBytes.size()) {
+            auto n = ::send(fd, outBytes.data() + outPos, outBytes.size() - outPos, MSG_NOSIGNAL);
+            if (n > 0) { outPos += (size_t)n; continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            finished = true;
+            return;
+        }
+        outBytes.clear();
+        outPos = 0;
+        if (inputClosed) finished = true;
+    }
+
+    juce::String describe() const {
+        double audioSeconds = sampleRate > 0.0 ? (double)samplesOut / sampleRate : 0.0;
+        double backlogMs = sampleRate > 0.0 ? 1000.0 * (double)((outBytes.size() - outPos) / bytesPerSample()) / sampleRate : 0.0;
+        return juce::String::formatted("session %d  %6.0f Hz  latency %5.1f ms  backlog %6.1f ms  audio %8.1f s  cpu %7.2f s  %7.1fxRT",
+                                       id, sampleRate, sampleRate > 0.0 ? 1000.0 * latency / sampleRate : 0.0, backlogMs,
+                                       audioSeconds, cpuSeconds, audioSeconds / juce::jmax(cpuSeconds, 1.0e-6));
+    }
+
+private:
+    static constexpr int blockSize = 1024;
+    static constexpr size_t maxBacklogBytes = 1 << 20;
+
+    size_t bytesPerSample() const { return format == Format::s16 ? 2 : 4; }
+
+    bool consume(const char* data, size_t size) {
+        if (!prepared) {
+            // "<sampleRate> <s16|f32>\n", then audio
+            while (size > 0 && !prepared) {
+                char c = *data++;
+                --size;
+                if (c != '\n') {
+                    if (header.length() > 64) return false;
+                    header += c;
+                    continue;
+                }
+                if (!prepare()) return false;
+            }
+            if (size == 0) return true;
+        }
+        pending.insert(pending.end(), data, data + size);
+        size_t numSamples = pending.size() / bytesPerSample();
+        if (numSamples > 0) {
+            processPending(numSamples);
+            pending.erase(pending.begin(), pending.begin() + (std::ptrdiff_t)(numSamples * bytesPerSample()));
+        }
+        return true;
+    }
+
+    bool prepare() {
+        auto tokens = juce::StringArray::fromTokens(juce::String(header).trim(), " ", {});
+        double rate = tokens.size() == 2 ? tokens[0].getDoubleValue() : 0.0;
+        if (rate < 8000.0 || rate > 192000.0 || (tokens[1] != "s16" && tokens[1] != "f32")) {
+            sendLine(fd, "error expected \"<sampleRate> <s16|f32>\"");
+            return false;
+        }
+        sampleRate = rate;
+        format = tokens[1] == "s16" ? Format::s16 : Format::f32;
+        channel->prepare(sampleRate, blockSize, false);
+        channel->reset(ChannelProcessor::Role::independent, nullptr, false);
+        latency = channel->getLatency();
+        samples.assign(blockSize, 0.0f);
+        appendText("ok " + juce::String(latency) + "\n");
+        prepared = true;
+        return true;
+    }
+
+    void processPending(size_t numSamples) {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        const char* bytes = pending.data();
+        for (size_t done = 0; done < numSamples;) {
+            int n = (int)juce::jmin<size_t>(blockSize, numSamples - done);
+            for (int i = 0; i < n; ++i) {
+                const char* src = bytes + (done + (size_t)i) * bytesPerSample();
+                if (format == Format::s16) {
+                    juce::int16 value;
+                    std::memcpy(&value, src, 2);
+                    samples[(size_t)i] = (float)value / 32768.0f;
+                } else {
+                    std::memcpy(&samples[(size_t)i], src, 4);
+                }
+            }
+            processBlock(n);
+            done += (size_t)n;
+        }
+        cpuSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    // samples[0, n) in place, appended to the output
+    void processBlock(int n) {
+        channel->process(samples.data(), n);
+        samplesOut += n;
+        size_t start = outBytes.size();
+        outBytes.resize(start + (size_t)n * bytesPerSample());
+        char* dest = outBytes.data() + start;
+        for (int i = 0; i < n; ++i) {
+            if (format == Format::s16) {
+                auto value = (juce::int16)juce::roundToInt(juce::jlimit(-1.0f, 1.0f, samples[(size_t)i]) * 32767.0f);
+                std::memcpy(dest + (size_t)i * 2, &value, 2);
+            } else {
+                std::memcpy(dest + (size_t)i * 4, &samples[(size_t)i], 4);
+            }
+        }
+    }
+
+    // the last `latency` samples are still inside the model: push zeros to get them out
+    void flushTail() {
+        for (int remaining = latency; remaining > 0;) {
+            int n = juce::jmin(blockSize, remaining);
+            std::fill_n(samples.begin(), n, 0.0f);
+            processBlock(n);
+            remaining -= n;
+        }
+        samplesOut -= latency; // not audio the client sent
+    }
+
+    void appendText(const juce::String& text) {
+        outBytes.insert(outBytes.end(), text.toRawUTF8(), text.toRawUTF8() + text.getNumBytesAsUTF8());
+    }
+
+    int fd;
+    int id;
+    std::unique_ptr<ChannelProcessor> channel;
+    std::string header;
+    bool prepared = false;
+    bool inputClosed = false;
+    bool finished = false;
+    double sampleRate = 0.0;
+    Format format = Format::s16;
+    int latency = 0;
+
+    std::vector<char> pending;  // a partial sample, between reads
+    std::vector<float> samples;
+    std::vector<char> outBytes; // not yet taken by the client
+    size_t outPos = 0;
+
+    juce::int64 samplesOut = 0;
+    double cpuSeconds = 0.0;
+};
+
+//==============================================================================
+class StreamServer::Worker : public juce::Thread {
+public:
+    Worker(StreamServer& o, int index)
+        : juce::Thread("Alt Denoiser Stream " + juce::String(index)), owner(o) {
+        if (::pipe(wakePipe) == 0) {
+            setNonBlocking(wakePipe[0]);
+            setNonBlocking(wakePipe[1]);
+        }
+    }
+
+    ~Worker() override {
+        signalThreadShouldExit();
+        wake();
+        stopThread(-1);
+        ::close(wakePipe[0]);
+        ::close(wakePipe[1]);
+    }
+
+    // loader threads
+    void add(std::unique_ptr<Session> session) {
+        {
+            const juce::ScopedLock sl(inboxLock);
+            inbox.push_back(std::move(session));
+        }
+        numSessions.fetch_add(1);
+        wake();
+    }
+
+    int getNumSessions() const { return numSessions.load(); }
+
+    void run() override {
+        std::vector<pollfd> fds;
+        auto lastStats = juce::Time::getMillisecondCounter();
+        while (!threadShouldExit()) {
+            {
+                const juce::ScopedLock sl(inboxLock);
+                for (auto& session : inbox)
+                    sessions.push_back(std::move(session));
+                inbox.clear();
+            }
+
+            fds.clear();
+            fds.push_back({ wakePipe[0], POLLIN, 0 });
+            for (auto& session : sessions)
+                fds.push_back({ session->getFd(), (short)((session->wantsInput() ? POLLIN : 0) | (session->wantsOutput() ? POLLOUT : 0)), 0 });
+
+            int timeout = owner.options.statsIntervalMs > 0 ? juce::jmin(owner.options.statsIntervalMs, 1000) : 1000;
+            if (::poll(fds.data(), (nfds_t)fds.size(), timeout) < 0 && errno != EINTR) {
+                owner.report("poll failed: " + juce::String(std::strerror(errno)));
+                return;
+            }
+            if (fds[0].revents != 0) {
+                char drain[64];
+                while (::read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            }
+
+            for (size_t i = 0; i < sessions.size(); ++i) {
+                auto revents = fds[i + 1].revents;
+                auto& session = *sessions[i];
+                if (revents & (POLLIN | POLLHUP)) session.onReadable();
+                if (revents & POLLERR) session.onReadable(); // picks up the error
+                if (!session.isFinished() && session.wantsOutput()) session.onWritable();
+            }
+
+            // closed sessions report once and give their model state back to the cache
+            for (auto it = sessions.begin(); it != sessions.end();) {
+                if (!(*it)->isFinished()) { ++it; continue; }
+                owner.report((*it)->describe() + "  closed");
+                it = sessions.erase(it);
+                numSessions.fetch_sub(1);
+                owner.numSessions.fetch_sub(1);
+            }
+
+            auto now = juce::Time::getMillisecondCounter();
+            if (owner.options.statsIntervalMs > 0 && now - lastStats >= (juce::uint32)owner.options.statsIntervalMs) {
+                lastStats = now;
+                for (auto& session : sessions)
+                    owner.report(session->describe());
+            }
+        }
+    }
+
+private:
+    void wake() {
+        char c = 0;
+        auto written = ::write(wakePipe[1], &c, 1);
+        juce::ignoreUnused(written);
+    }
+
+    StreamServer& owner;
+    int wakePipe[2] = { -1, -1 };
+    juce::CriticalSection inboxLock;
+    std::vector<std::unique_ptr<Session>> inbox;
+    std::vector<std::unique_ptr<Session>> sessions; // worker thread only
+    std::atomic<int> numSessions { 0 };
+};
+
+//==============================================================================
+class StreamServer::Loader : public juce::ThreadPoolJob {
+public:
+    Loader(StreamServer& o, std::unique_ptr<Session> s)
+        : juce::ThreadPoolJob("Alt Denoiser Load"), owner(o), session(std::move(s)) {}
+
+    JobStatus runJob() override {
+        const int fd = session->getFd();
+        const int id = session->getId();
+        if (!session->initialize(owner.options)) {
+            sendLine(fd, "error model failed to load");
+            owner.report("session " + juce::String(id) + " refused, model failed to load");
+        } else if (setNonBlocking(fd)) {
+            owner.assign(std::move(session));
+            return jobHasFinished;
+        }
+        session.reset();
+        owner.numSessions.fetch_sub(1);
+        return jobHasFinished;
+    }
+
+private:
+    StreamServer& owner;
+    std::unique_ptr<Session> session; // closed with the job if stop() drops it unloaded
+};
+
+//==============================================================================
+class StreamServer::Acceptor : public juce::Thread {
+public:
+    explicit Acceptor(StreamServer& o) : juce::Thread("Alt Denoiser Accept"), owner(o) {}
+    ~Acceptor() override { stopThread(-1); }
+
+    void run() override {
+        while (!threadShouldExit()) {
+            // polled, so stop() doesn't have to close the socket under us
+            pollfd pfd { owner.listenFd, POLLIN, 0 };
+            if (::poll(&pfd, 1, 250) <= 0) continue;
+            int fd = ::accept(owner.listenFd, nullptr, nullptr);
+            if (fd < 0) continue;
+
+            int id = owner.nextSessionId.fetch_add(1);
+            if (owner.numSessions.load() >= owner.options.maxSessions) {
+                sendLine(fd, "error busy");
+                ::close(fd);
+                owner.report("session " + juce::String(id) + " refused, at the limit");
+                continue;
+            }
+            // counted from here, so sessions still loading count against the limit too
+            owner.numSessions.fetch_add(1);
+            owner.loaders->addJob(new Loader(owner, std::make_unique<Session>(fd, id)), true);
+        }
+    }
+
+private:
+    StreamServer& owner;
+};
+
+//==============================================================================
+StreamServer::StreamServer(const Options& o) : options(o) {
+}
+
+StreamServer::~StreamServer() {
+    stop();
+}
+
+bool StreamServer::start(const juce::String& socketPath) {
+    stop();
+    sockaddr_un address {};
+    if (socketPath.getNumBytesAsUTF8() >= sizeof(address.sun_path)) {
+        report("socket path too long: " + socketPath);
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.toRawUTF8(), sizeof(address.sun_path) - 1);
+
+    // a previous run that died leaves its socket file behind; anything else at the path stays
+    struct stat info;
+    if (::lstat(address.sun_path, &info) == 0 && S_ISSOCK(info.st_mode))
+        ::unlink(address.sun_path);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0
+        || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listenFd, 128) != 0) {
+        report("can't listen on " + socketPath + ": " + juce::String(std::strerror(errno)));
+        if (listenFd >= 0) ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    path = socketPath;
+
+    int numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    for (int i = 0; i < numThreads; ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->startThread();
+    }
+    // df_create is mostly single-threaded work; a few at a time cover a burst of connections
+    loaders = std::make_unique<juce::ThreadPool>(juce::jlimit(1, maxLoaderThreads, numThreads));
+    acceptor = std::make_unique<Acceptor>(*this);
+    acceptor->startThread();
+    report("listening on " + socketPath + " with " + juce::String(numThreads) + " workers");
+    return true;
+}
+
+void StreamServer::stop() {
+    acceptor.reset();
+    // a load in progress finishes and is handed to its worker, the ones still queued are dropped
+    if (loaders != nullptr)
+        loaders->removeAllJobs(true, -1);
+    loaders.reset();
+    workers.clear();
+    numSessions = 0;
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(path.toRawUTF8());
+        listenFd = -1;
+    }
+}
+
+void StreamServer::assign(std::unique_ptr<Session> session) {
+    auto* target = workers.front().get();
+    for (auto& worker : workers)
+        if (worker->getNumSessions() < target->getNumSessions())
+            target = worker.get();
+    target->add(std::move(session));
+}
+
+void StreamServer::report(const juce::String& line) {
+    const juce::ScopedLock sl(reportLock);
+    std::printf("%s\n", line.toRawUTF8());
+    std::fflush(stdout);
+}
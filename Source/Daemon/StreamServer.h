@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "ChannelProcessor.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Serves denoising over a Unix domain socket, one mono stream per connection.
+// A client opens with one text line, "<sampleRate> <s16|f32>\n", gets back "ok <latency>\n"
+// (latency in samples at its rate) and then streams native-endian PCM both ways: whatever
+// it writes comes back denoised, latency samples later. Shutting down its write side
+// flushes the tail and closes the connection.
+//
+// The acceptor thread only accepts. Each session's own model state is loaded on a small
+// pool of loader threads, several at once, so a burst of connections isn't served one
+// df_create after another and no worker ever waits for one. A loaded session goes to the
+// worker with the fewest; every worker polls all of its sockets and runs whatever audio has
+// arrived. A stream only costs CPU while it sends, and quiet hops skip the model.
+class StreamServer {
+public:
+    struct Options {
+        int numThreads = 0;      // 0 = one per core
+        int maxSessions = 512;
+        float attenLim = 100.0f;
+        int modelVariant = ModelCache::defaultVariant;
+        int statsIntervalMs = 10000; // 0 = only when a session closes
+    };
+
+    explicit StreamServer(const Options& options);
+    ~StreamServer();
+
+    // binds the socket, replacing a stale one left at the path; false if that fails
+    bool start(const juce::String& socketPath);
+    void stop();
+
+    int getNumSessions() const { return numSessions.load(); }
+
+private:
+    class Session;
+    class Worker;
+    class Acceptor;
+    class Loader;
+
+    // loader threads: to the worker with the fewest sessions
+    void assign(std::unique_ptr<Session> session);
+    // any thread: prints one line
+    void report(const juce::String& line);
+
+    static constexpr int maxLoaderThreads = 4;
+
+    Options options;
+    juce::String path;
+    int listenFd = -1;
+    std::unique_ptr<Acceptor> acceptor;
+    std::unique_ptr<juce::ThreadPool> loaders;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<int> numSessions { 0 }; // loading ones included
+    std::atomic<int> nextSessionId { 1 };
+    juce::CriticalSection reportLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StreamServer)
+};
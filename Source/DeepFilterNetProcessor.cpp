@@ -1,58 +1,93 @@
 #include "DeepFilterNetProcessor.h"
-#include "BinaryData.h"
-#include <fstream>
-#include <iostream>
-#include <string>
 #include <juce_core/juce_core.h>
 
-DeepFilterNetProcessor::DeepFilterNetProcessor(uint32_t sampleRate)
-    : sampleRate(sampleRate) {
+DeepFilterNetProcessor::DeepFilterNetProcessor() {
 }
 
 DeepFilterNetProcessor::~DeepFilterNetProcessor() {
-    if (state != nullptr) {
-        df_free(state);
+    releaseRetired();
+    if (auto* model = pending.exchange(nullptr)) {
+        modelCache->releaseState(model->variant, model->state);
+        delete model;
     }
+    modelCache->releaseState(variant.load(), state.load());
 }
 
-bool DeepFilterNetProcessor::initialize()
+bool DeepFilterNetProcessor::initialize(int newVariant)
 {
-    const char* modelData = AltDenoiserBinaryData::DeepFilterNet3_onnx_tar_gz;
-    const int modelSize   = AltDenoiserBinaryData::DeepFilterNet3_onnx_tar_gzSize;
+    if (getLoadedVariant() == newVariant) return true;
+    releaseRetired();
 
-    if (modelSize <= 0 || modelData == nullptr)
-    {
-        DBG("Embedded model data invalid or missing");
-        return false;
+    // a spare state of a closed instance if there is one, else a fresh df_create
+    auto* newState = modelCache->acquireState(newVariant);
+    if (newState == nullptr) return false;
+    df_set_atten_lim(newState, 100.0f);
+
+    // replaces a pending model that was never adopted
+    pendingVariant.store(newVariant);
+    if (auto* stale = pending.exchange(new Model { newState, newVariant })) {
+        modelCache->releaseState(stale->variant, stale->state);
+        delete stale;
     }
+    return true;
+}
+
+bool DeepFilterNetProcessor::hasPending(int requiredSampleRate) const {
+    if (pending.load() == nullptr) return false;
+    return requiredSampleRate <= 0 || ModelCache::variants[(size_t)pendingVariant.load()].sampleRate == requiredSampleRate;
+}
+
+bool DeepFilterNetProcessor::adoptPending(int requiredSampleRate) {
+    auto* model = pending.exchange(nullptr);
+    if (model == nullptr) return false;
 
-    auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory);
-    auto tempModel = tempDir.getChildFile("alt_denoiser_model.tar.gz");
-
-    {
-        juce::FileOutputStream stream(tempModel);
-        if (!stream.openedOk()) 
-        {
-            DBG("Failed to open temp file for model");
-            return false;
-        }
-        stream.write(modelData, modelSize);
-        stream.flush();
+    if (requiredSampleRate > 0 && ModelCache::variants[(size_t)model->variant].sampleRate != requiredSampleRate) {
+        // needs a prepare() at its own rate: put it back, unless the loader has already replaced it
+        Model* expected = nullptr;
+        if (!pending.compare_exchange_strong(expected, model))
+            retire(model);
+        return false;
     }
 
-    state = df_create(tempModel.getFullPathName().toRawUTF8(), 100.0f, nullptr);
-    return state != nullptr;
+    // hand the old state back in the same Model, nothing is allocated here
+    auto* oldState = state.exchange(model->state);
+    auto oldVariant = variant.exchange(model->variant);
+    model->state = oldState;
+    model->variant = oldVariant;
+    retire(model);
+    return true;
+}
+
+int DeepFilterNetProcessor::getLoadedVariant() const {
+    if (pending.load() != nullptr) return pendingVariant.load();
+    return state.load() != nullptr ? variant.load() : -1;
+}
+
+void DeepFilterNetProcessor::retire(Model* model) {
+    model->next = retired.load();
+    while (!retired.compare_exchange_weak(model->next, model)) {}
+}
+
+void DeepFilterNetProcessor::releaseRetired() {
+    auto* model = retired.exchange(nullptr);
+    while (model != nullptr) {
+        auto* next = model->next;
+        modelCache->releaseState(model->variant, model->state);
+        delete model;
+        model = next;
+    }
 }
 
 void DeepFilterNetProcessor::setAttenLim(float limitDB) {
-    if (state != nullptr) {
+    if (auto* s = state.load()) {
         // 调用 df.h 中定义的 C 接口
-        df_set_atten_lim(state, limitDB);
+        df_set_atten_lim(s, limitDB);
     }
 }
 
-void DeepFilterNetProcessor::processFrame(const float* input, float* output) {
-    if (state) {
-        df_process_frame(state, (float*)input, output);
+float DeepFilterNetProcessor::processFrame(const float* input, float* output) {
+    if (auto* s = state.load()) {
+        return df_process_frame(s, (float*)input, output);
     }
-}
\ No newline at end of file
+    return 0.0f;
+}
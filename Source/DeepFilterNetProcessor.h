@@ -1,20 +1,57 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <vector>
+#include <juce_core/juce_core.h>
 #include "df.h"
+#include "ModelCache.h"
 
 class DeepFilterNetProcessor {
 public:
-    DeepFilterNetProcessor(uint32_t sampleRate = 48000);
+    DeepFilterNetProcessor();
     ~DeepFilterNetProcessor();
 
-    bool initialize(); 
+    // not real-time safe, may run on a background thread: loads the variant as the pending
+    // model, which takes over at the next adoptPending(); free if it is already loaded
+    bool initialize(int variant = ModelCache::defaultVariant);
+    // on the processing thread, or while nothing processes: swaps the pending model in.
+    // real-time safe; the replaced state is released by the next initialize().
+    // With requiredSampleRate > 0 a model trained at another rate is left pending
+    bool adoptPending(int requiredSampleRate = 0);
+    // with requiredSampleRate > 0, only a pending model trained at that rate counts
+    bool hasPending(int requiredSampleRate = 0) const;
+    // any thread: variant of the pending model if there is one, else of the current one; -1 for none
+    int getLoadedVariant() const;
     void setAttenLim(float limitDB);
     
-    void processFrame(const float* input, float* output);
-    bool isReady() const { return state != nullptr; }
+    // returns the model's local SNR estimate for the frame, in dB
+    float processFrame(const float* input, float* output);
+    bool isReady() const { return state.load() != nullptr; }
+
+    // rate the current model runs at, the default variant's until one is loaded
+    int getSampleRate() const { return ModelCache::variants[(size_t)variant.load()].sampleRate; }
+    // hop size in samples, at getSampleRate(); every variant hops 10 ms
+    int getFrameLength() const { auto* s = state.load(); return s != nullptr ? (int)df_get_frame_length(s) : getSampleRate() / 100; }
+    // output lags input by the STFT overlap (one hop) plus the variant's lookahead hops
+    int getModelDelay() const { return (1 + ModelCache::variants[(size_t)variant.load()].lookaheadHops) * getFrameLength(); }
 
 private:
-    DFState* state = nullptr;
-    uint32_t sampleRate = 48000;
+    struct Model {
+        DFState* state = nullptr;
+        int variant = 0;
+        Model* next = nullptr; // in the retired list
+    };
+
+    void releaseRetired();
+    // lock-free push, so the processing thread can retire more than one model between loads
+    void retire(Model* model);
+
+    juce::SharedResourcePointer<ModelCache> modelCache;
+    std::atomic<DFState*> state { nullptr }; // only changed by adoptPending()
+    std::atomic<int> variant { ModelCache::defaultVariant };
+    std::atomic<Model*> pending { nullptr }; // loader -> processing thread
+    // variant of the pending model, published before pending so it is never older than it;
+    // other threads read this instead of the Model, which adoptPending() reuses and retires
+    std::atomic<int> pendingVariant { ModelCache::defaultVariant };
+    std::atomic<Model*> retired { nullptr }; // processing thread -> loader
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "LevelMeter.h"
+#include <vector>
+
+// Delays the dry signal by the plugin's reported latency, so it lines up with the wet one.
+class DryDelay {
+public:
+    // not real-time safe
+    void prepare(int numChannels, int maxDelay) {
+        lines.assign(numChannels, std::vector<float>(maxDelay + 1, 0.0f));
+        delay = juce::jmin(delay, maxDelay);
+        writePos = 0;
+    }
+
+    void reset() {
+        for (auto& line : lines)
+            std::fill(line.begin(), line.end(), 0.0f);
+        writePos = 0;
+    }
+
+    // samples must fit the maxDelay given to prepare()
+    void setDelay(int samples) {
+        jassert(lines.empty() || (samples >= 0 && samples < (int)lines[0].size()));
+        delay = lines.empty() ? 0 : juce::jlimit(0, (int)lines[0].size() - 1, samples);
+    }
+    int getDelay() const { return delay; }
+
+    // writes the input, delayed, into output; both may have different sizes. Every sample of
+    // the input passes through here once, so its levels are measured on the way for the meter
+    void process(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output, int numChannels, int numSamples,
+                 LevelMeter& inputMeter) {
+        if (lines.empty()) return;
+        const int size = (int)lines[0].size();
+        numChannels = juce::jmin(numChannels, (int)lines.size());
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            auto* line = lines[ch].data();
+            auto* in = input.getReadPointer(ch);
+            auto* out = output.getWritePointer(ch);
+            int w = writePos;
+            int r = (writePos - delay + size) % size;
+            float peak = 0.0f, sumSquares = 0.0f;
+            for (int i = 0; i < numSamples; ++i) {
+                const float x = in[i];
+                line[w] = x;
+                out[i] = line[r];
+                peak = juce::jmax(peak, std::abs(x));
+                sumSquares += x * x;
+                if (++w == size) w = 0;
+                if (++r == size) r = 0;
+            }
+            inputMeter.pushInput(ch, peak, sumSquares, numSamples);
+        }
+        writePos = (writePos + numSamples) % size;
+    }
+
+private:
+    std::vector<std::vector<float>> lines;
+    int delay = 0;
+    int writePos = 0;
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "WakeSemaphore.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Always-on record of what the audio path did over the last few seconds, for dropouts that
+// can't be reproduced. Any thread appends fixed-size events to a ring with one atomic add and a
+// handful of relaxed stores; nothing is allocated, locked or formatted on the way in.
+// When a block overruns its deadline, or someone asks, the ring is frozen, copied out and
+// written as a Chrome / Perfetto trace (chrome://tracing, ui.perfetto.dev) by a low-priority
+// thread that every recorder in the process shares, asleep until a trigger wakes it. Traces go to $ALT_DENOISER_TRACE_DIR, or "Alt Denoiser/Traces" in the user's
+// application data folder; only the newest maxTraceFiles are kept.
+class FlightRecorder {
+public:
+    enum class Type : juce::uint8 {
+        block,      // span: a = host samples, b = deadline in ms
+        toModel,    // span: a = host samples, b = model samples
+        fromModel,  // span: a = model samples, b = host samples
+        resample,   // span: the generic resampler's whole round trip, model work nested inside
+        inference,  // span: a = hops
+        fifo,       // counter: a = input fill, b = output fill
+        parameter,  // instant: a = parameter index, b = value
+        underrun,   // instant
+        overflow,   // instant: a = samples dropped
+        overrun,    // instant: a = block time in ms, b = deadline in ms
+        request     // instant: a trace was asked for
+    };
+
+    static constexpr int capacity = 1 << 15; // events, several seconds even at 32-sample blocks
+    static constexpr int maxTraceFiles = 10;
+    static constexpr juce::uint32 cooldownMs = 10000; // one trace per burst of overruns
+
+    FlightRecorder() : slots(new Slot[(size_t)capacity]) {
+        auto dir = juce::SystemStats::getEnvironmentVariable("ALT_DENOISER_TRACE_DIR", {});
+        folder = juce::File::isAbsolutePath(dir)
+               ? juce::File(dir)
+               : juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("Alt Denoiser/Traces");
+        writer->add(this);
+    }
+
+    // waits for a trace of ours that is being written
+    ~FlightRecorder() { writer->remove(this); }
+
+    // not real-time safe: names for parameter events, in index order
+    void setParameterNames(const juce::StringArray& names) {
+        const juce::ScopedLock sl(infoLock);
+        parameterNames = names;
+    }
+    // not real-time safe: sample rate, block size and so on, for the trace's header
+    void setContext(const juce::String& description) {
+        const juce::ScopedLock sl(infoLock);
+        context = description;
+    }
+
+    static juce::int64 now() { return juce::Time::getHighResolutionTicks(); }
+
+    // any thread, real-time safe
+    void span(Type type, juce::int64 start, juce::int64 end, int channel, float a = 0.0f, float b = 0.0f) {
+        write(type, start, end, channel, a, b);
+    }
+    void span(Type type, juce::int64 start, int channel, float a = 0.0f, float b = 0.0f) {
+        write(type, start, now(), channel, a, b);
+    }
+    void mark(Type type, int channel, float a = 0.0f, float b = 0.0f) {
+        auto t = now();
+        write(type, t, t, channel, a, b);
+    }
+
+    // any thread, real-time safe: records the reason, freezes the ring and has it written out.
+    // Overruns within cooldownMs of the last trace only leave their mark
+    void trigger(Type reason, float a = 0.0f, float b = 0.0f) {
+        mark(reason, -1, a, b);
+        const auto nowMs = juce::Time::getMillisecondCounter();
+        if (reason == Type::overrun && hasDumped.load() && nowMs - lastDumpMs.load() < cooldownMs) return;
+        bool expected = false;
+        if (!frozen.compare_exchange_strong(expected, true)) return; // already on its way out
+        frozenReason.store((int)reason);
+        lastDumpMs.store(nowMs);
+        hasDumped.store(true);
+        writer->wake();
+    }
+
+    // the newest trace written, if any
+    juce::File getLastTrace() const {
+        const juce::ScopedLock sl(infoLock);
+        return lastTrace;
+    }
+
+private:
+    struct Slot {
+        std::atomic<juce::uint64> sequence { 0 }; // 2 * index + 2 once written, odd while being written
+        std::atomic<juce::int64> start { 0 };
+        std::atomic<juce::int64> end { 0 };
+        std::atomic<juce::uint64> thread { 0 };
+        std::atomic<juce::uint32> info { 0 }; // type | (channel + 1) << 8
+        std::atomic<float> a { 0.0f };
+        std::atomic<float> b { 0.0f };
+    };
+
+    struct Event {
+        juce::int64 start, end;
+        juce::uint64 thread;
+        Type type;
+        int channel;
+        float a, b;
+    };
+
+    void write(Type type, juce::int64 start, juce::int64 end, int channel, float a, float b) {
+        // while frozen the ring is being read; what happens meanwhile is lost, not the window
+        if (frozen.load(std::memory_order_relaxed)) return;
+        const auto index = head.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = slots[(size_t)(index & (capacity - 1))];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.thread.store((juce::uint64)(juce::pointer_sized_int)juce::Thread::getCurrentThreadId(), std::memory_order_relaxed);
+        slot.info.store((juce::uint32)type | (juce::uint32)(channel + 1) << 8, std::memory_order_relaxed);
+        slot.a.store(a, std::memory_order_relaxed);
+        slot.b.store(b, std::memory_order_relaxed);
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    // every event still whole in the ring, oldest first
+    std::vector<Event> copyOut() const {
+        const auto end = head.load();
+        const auto begin = end > (juce::uint64)capacity ? end - (juce::uint64)capacity : 0;
+        std::vector<Event> events;
+        events.reserve((size_t)(end - begin));
+        for (auto index = begin; index < end; ++index) {
+            const auto& slot = slots[(size_t)(index & (capacity - 1))];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            Event e;
+            e.start = slot.start.load(std::memory_order_relaxed);
+            e.end = slot.end.load(std::memory_order_relaxed);
+            e.thread = slot.thread.load(std::memory_order_relaxed);
+            const auto info = slot.info.load(std::memory_order_relaxed);
+            e.a = slot.a.load(std::memory_order_relaxed);
+            e.b = slot.b.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // torn or overwritten while we read it
+            if (sequence != 2 * index + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+            e.type = (Type)(info & 0xff);
+            e.channel = (int)(info >> 8) - 1;
+            events.push_back(e);
+        }
+        return events;
+    }
+
+    // one per process, shared by every recorder
+    class Writer : private juce::Thread {
+    public:
+        Writer() : juce::Thread("Alt Denoiser Flight Recorder") { startThread(juce::Thread::Priority::low); }
+        ~Writer() override {
+            signalThreadShouldExit();
+            wakeup.signal(1);
+            stopThread(2000);
+        }
+
+        void add(FlightRecorder* recorder) {
+            const juce::ScopedLock sl(lock);
+            recorders.add(recorder);
+        }
+        void remove(FlightRecorder* recorder) {
+            const juce::ScopedLock sl(lock);
+            recorders.removeFirstMatchingValue(recorder);
+        }
+        // any thread, real-time safe; a wake-up while writing makes it look again afterwards
+        void wake() { wakeup.notify(); }
+
+    private:
+        void run() override {
+            while (!threadShouldExit()) {
+                wakeup.wait(-1);
+                const juce::ScopedLock sl(lock);
+                for (auto* recorder : recorders)
+                    recorder->writeIfFrozen();
+            }
+        }
+
+        juce::CriticalSection lock; // never taken by writers of events
+        juce::Array<FlightRecorder*> recorders;
+        WakeSemaphore wakeup;
+    };
+
+    // on the writer's thread
+    void writeIfFrozen() {
+        if (!frozen.load()) return;
+        auto events = copyOut();
+        frozen.store(false);
+        writeTrace(events, (Type)frozenReason.load());
+    }
+
+    void writeTrace(const std::vector<Event>& events, Type reason) {
+        if (events.empty() || !folder.createDirectory()) return;
+        juce::StringArray names;
+        juce::String header;
+        {
+            const juce::ScopedLock sl(infoLock);
+            names = parameterNames;
+            header = context;
+        }
+
+        // small thread numbers in order of appearance; the one that runs blocks is the audio thread
+        std::map<juce::uint64, int> threadIds;
+        std::map<int, bool> runsBlocks;
+        for (const auto& e : events) {
+            auto it = threadIds.emplace(e.thread, (int)threadIds.size() + 1).first;
+            if (e.type == Type::block) runsBlocks[it->second] = true;
+        }
+
+        const double ticksToUs = 1.0e6 / (double)juce::Time::getHighResolutionTicksPerSecond();
+        const juce::int64 origin = std::min_element(events.begin(), events.end(),
+                                                    [](const Event& x, const Event& y) { return x.start < y.start; })->start;
+        auto us = [&](juce::int64 ticks) { return juce::String((double)(ticks - origin) * ticksToUs, 3); };
+        auto channelName = [](int channel) { return channel >= 0 ? " ch" + juce::String(channel) : juce::String(); };
+
+        juce::MemoryOutputStream out;
+        out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"reason\":\"" << (reason == Type::overrun ? "overrun" : "request")
+            << "\",\"context\":" << juce::JSON::toString(header) << "},\"traceEvents\":[\n"
+            << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"Alt Denoiser\"}}";
+        for (const auto& [thread, id] : threadIds)
+            out << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << id
+                << ",\"args\":{\"name\":\"" << (runsBlocks.count(id) > 0 ? "audio" : "worker " + juce::String(id)) << "\"}}";
+
+        for (const auto& e : events) {
+            const int tid = threadIds[e.thread];
+            out << ",\n{\"pid\":1,\"tid\":" << tid << ",\"ts\":" << us(e.start);
+            switch (e.type) {
+                case Type::block:
+                    out << ",\"ph\":\"X\",\"name\":\"block\",\"dur\":" << juce::String((double)(e.end - e.start) * ticksToUs, 3)
+                        << ",\"args\":{\"samples\":" << (int)e.a << ",\"deadline_ms\":" << e.b << "}}";
+                    break;
+                case Type::toModel:
+                case Type::fromModel:
+                case Type::resample:
+                case Type::inference: {
+                    const char* name = e.type == Type::toModel ? "to model rate"
+                                     : e.type == Type::fromModel ? "from model rate"
+                                     : e.type == Type::resample ? "resample" : "inference";
+                    out << ",\"ph\":\"X\",\"name\":\"" << name << channelName(e.channel) << "\",\"dur\":"
+                        << juce::String((double)(e.end - e.start) * ticksToUs, 3) << ",\"args\":{";
+                    if (e.type == Type::inference) out << "\"hops\":" << (int)e.a;
+                    else out << "\"in\":" << (int)e.a << ",\"out\":" << (int)e.b;
+                    out << "}}";
+                    break;
+                }
+                case Type::fifo:
+                    out << ",\"ph\":\"C\",\"name\":\"fifo" << channelName(e.channel) << "\",\"args\":{\"input\":"
+                        << (int)e.a << ",\"output\":" << (int)e.b << "}}";
+                    break;
+                case Type::parameter: {
+                    const int index = (int)e.a;
+                    out << ",\"ph\":\"i\",\"s\":\"p\",\"name\":\"" << (juce::isPositiveAndBelow(index, names.size()) ? names[index] : "parameter")
+                        << "\",\"args\":{\"value\":" << e.b << "}}";
+                    break;
+                }
+                case Type::underrun:
+                    out << ",\"ph\":\"i\",\"s\":\"t\",\"name\":\"underrun" << channelName(e.channel) << "\"}";
+                    break;
+                case Type::overflow:
+                    out << ",\"ph\":\"i\",\"s\":\"t\",\"name\":\"overflow" << channelName(e.channel)
+                        << "\",\"args\":{\"samples\":" << (int)e.a << "}}";
+                    break;
+                case Type::overrun:
+                    out << ",\"ph\":\"i\",\"s\":\"g\",\"name\":\"overrun\",\"args\":{\"block_ms\":" << e.a
+                        << ",\"deadline_ms\":" << e.b << "}}";
+                    break;
+                case Type::request:
+                    out << ",\"ph\":\"i\",\"s\":\"g\",\"name\":\"trace requested\"}";
+                    break;
+            }
+        }
+        out << "\n]}\n";
+
+        auto file = folder.getChildFile("alt-denoiser-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json")
+                          .getNonexistentSibling();
+        if (!file.replaceWithData(out.getData(), out.getDataSize())) {
+            DBG("Failed to write trace: " + file.getFullPathName());
+            return;
+        }
+        {
+            const juce::ScopedLock sl(infoLock);
+            lastTrace = file;
+        }
+
+        auto traces = folder.findChildFiles(juce::File::findFiles, false, "alt-denoiser-*.json");
+        std::sort(traces.begin(), traces.end(), [](const juce::File& x, const juce::File& y) {
+            return x.getLastModificationTime() > y.getLastModificationTime();
+        });
+        for (int i = maxTraceFiles; i < traces.size(); ++i)
+            traces[i].deleteFile();
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<juce::uint64> head { 0 };
+    std::atomic<bool> frozen { false };
+    std::atomic<int> frozenReason { 0 };
+    std::atomic<bool> hasDumped { false };
+    std::atomic<juce::uint32> lastDumpMs { 0 };
+
+    juce::File folder;
+    juce::CriticalSection infoLock; // never taken by writers
+    juce::StringArray parameterNames;
+    juce::String context;
+    juce::File lastTrace;
+
+    juce::SharedResourcePointer<Writer> writer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FlightRecorder)
+};
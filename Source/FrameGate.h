@@ -0,0 +1,133 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+#include <vector>
+
+// Decides per hop whether the model has to run at all.
+// A hop is quiet when its energy is below the floor, or when the model's last LSNR said
+// "noise only" and the energy hasn't risen above that noise. After a hangover of quiet hops
+// the gate closes and the channel outputs its input, delayed like the model would, at the
+// attenuation limit. When it opens again the model first catches up on the hops it missed,
+// so its lookahead is valid and onsets come through untouched. Both edges crossfade over one hop.
+class FrameGate {
+public:
+    enum class Action {
+        infer, // run the model as usual
+        skip,  // don't run it, use writeBypass()
+        close, // run it one last time and fade out to the bypass
+        open   // run the pre-roll hops, then this one, and fade in from the bypass
+    };
+
+    // modelDelay: how far the model's output lags its input, in model-rate samples
+    void prepare(int newFrameLength, int modelDelay) {
+        frameLength = newFrameLength;
+        delayFrames = juce::jmax(0, modelDelay / frameLength);
+        // the pre-roll hops, plus the current one
+        history.assign((size_t)((delayFrames + 2) * frameLength), 0.0f);
+        reset();
+    }
+
+    void reset() {
+        std::fill(history.begin(), history.end(), 0.0f);
+        isOpen = true;
+        quietFrames = 0;
+        lastEnergyDb = -120.0f;
+        lastLsnr = 35.0f;
+        noiseDb = -120.0f;
+    }
+
+    // every hop, before inference; forceClosed shuts the gate whatever the hop sounds like
+    Action analyse(const float* input, bool enabled, float floorDb, bool forceClosed = false) {
+        // keep the last hops around for the bypass delay and the pre-roll
+        std::copy(history.begin() + frameLength, history.end(), history.begin());
+        std::copy(input, input + frameLength, history.end() - frameLength);
+
+        float energy = 0.0f;
+        for (int i = 0; i < frameLength; ++i)
+            energy += input[i] * input[i];
+        lastEnergyDb = 10.0f * std::log10(energy / (float)frameLength + 1.0e-12f);
+
+        bool quiet = lastEnergyDb < floorDb
+                  || (lastLsnr < lsnrFloorDb && lastEnergyDb < noiseDb + onsetMarginDb);
+
+        if (forceClosed) {
+            if (!isOpen) return Action::skip;
+            isOpen = false;
+            quietFrames = 0;
+            return Action::close;
+        }
+        if (isOpen) {
+            quietFrames = enabled && quiet ? quietFrames + 1 : 0;
+            if (quietFrames < hangoverFrames) return Action::infer;
+            isOpen = false;
+            return Action::close;
+        }
+        if (enabled && quiet) return Action::skip;
+        isOpen = true;
+        quietFrames = 0;
+        return Action::open;
+    }
+
+    // energy of the hop last passed to analyse()
+    float getLastEnergyDb() const { return lastEnergyDb; }
+    // what hops the model called noise sounded like, -120 until it has called one
+    float getNoiseDb() const { return noiseDb; }
+
+    // after every inferred hop, with that hop's energy
+    void inferred(float lsnr, float energyDb) {
+        lastLsnr = lsnr;
+        // remember what "noise only" sounds like, so a rise above it reopens the gate
+        if (lsnr < lsnrFloorDb)
+            noiseDb = noiseDb <= -120.0f ? energyDb : 0.8f * noiseDb + 0.2f * energyDb;
+    }
+
+    // the hops the model missed while closed, oldest first
+    int getNumPrerollFrames() const { return delayFrames + 1; }
+    const float* getPrerollFrame(int index) const { return history.data() + index * frameLength; }
+
+    // the input hop the model's current output belongs to, scaled by gain
+    void writeBypass(float* output, float gain) const {
+        juce::FloatVectorOperations::copyWithMultiply(output, getDelayedInput(), gain, frameLength);
+    }
+
+    // the same, ramping from the previous hop's gain
+    void writeBypass(float* output, float gain, float previousGain) const {
+        if (gain == previousGain) {
+            writeBypass(output, gain);
+            return;
+        }
+        const float* bypass = getDelayedInput();
+        const float step = (gain - previousGain) / (float)frameLength;
+        for (int i = 0; i < frameLength; ++i)
+            output[i] = bypass[i] * (previousGain + step * (float)(i + 1));
+    }
+
+    // fadeIn: bypass -> output, otherwise output -> bypass
+    void crossfade(float* output, float gain, bool fadeIn) const {
+        const float* bypass = getDelayedInput();
+        for (int i = 0; i < frameLength; ++i) {
+            float t = (float)(i + 1) / (float)frameLength;
+            float wet = fadeIn ? t : 1.0f - t;
+            output[i] = wet * output[i] + (1.0f - wet) * gain * bypass[i];
+        }
+    }
+
+private:
+    static constexpr int hangoverFrames = 20;   // 200 ms of quiet before closing
+    static constexpr float lsnrFloorDb = -10.0f; // DeepFilterNet's LSNR bottoms out around -15 dB on noise
+    static constexpr float onsetMarginDb = 6.0f;
+
+    const float* getDelayedInput() const {
+        return history.data() + (history.size() - (size_t)((delayFrames + 1) * frameLength));
+    }
+
+    std::vector<float> history;
+    int frameLength = 480;
+    int delayFrames = 3;
+    bool isOpen = true;
+    int quietFrames = 0;
+    float lastEnergyDb = -120.0f;
+    float lastLsnr = 35.0f;
+    float noiseDb = -120.0f;
+};
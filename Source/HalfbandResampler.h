@@ -0,0 +1,106 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <cmath>
+
+// Exact 2:1 converter for hosts at twice the model rate: halfband FIR decimation to it and
+// halfband FIR interpolation back. The ratio and filter length are fixed at compile time.
+// Blocks may have any length, odd ones included; the half-rate phase carries over.
+class HalfbandResampler {
+public:
+    static constexpr int numTaps = 63; // Blackman windowed sinc, ~-74 dB stopband
+    static constexpr int centre = (numTaps - 1) / 2;
+    static constexpr int numHalfRateTaps = (numTaps + 1) / 2;
+
+    HalfbandResampler() {
+        for (int i = 0; i < numTaps; ++i) {
+            double n = i - centre;
+            double sinc = n == 0 ? 0.5 : std::sin(juce::MathConstants<double>::halfPi * n) / (juce::MathConstants<double>::pi * n);
+            double window = 0.42 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * i / (numTaps - 1))
+                                 + 0.08 * std::cos(2.0 * juce::MathConstants<double>::twoPi * i / (numTaps - 1));
+            taps[i] = (float)(sinc * window);
+        }
+        reset();
+    }
+
+    void reset() {
+        decimatorHistory.fill(0.0f);
+        interpolatorHistory.fill(0.0f);
+        decimatorPos = 0;
+        interpolatorPos = 0;
+        decimatorPhase = 0;
+        interpolatorPhase = 0;
+        // one half-rate sample of slack, so the interpolator never runs ahead of the decimator
+        pendingCount = 1;
+        pending[0] = 0.0f;
+    }
+
+    // total delay of decimate + interpolate, in host samples
+    static constexpr int getLatency() { return 2 * centre + 1; }
+
+    // host rate -> model rate, returns the number of samples written (numSamples / 2, +-1)
+    int decimate(const float* input, float* output, int numSamples) {
+        int numOut = 0;
+        for (int i = 0; i < numSamples; ++i) {
+            // doubled history, so the newest numTaps samples are always contiguous
+            decimatorHistory[decimatorPos] = input[i];
+            decimatorHistory[decimatorPos + numTaps] = input[i];
+            if (++decimatorPos == numTaps) decimatorPos = 0;
+
+            if (++decimatorPhase == 2) {
+                decimatorPhase = 0;
+                const float* x = decimatorHistory.data() + decimatorPos; // oldest first
+                float sum = 0.0f;
+                for (int k = 0; k < numTaps; ++k)
+                    sum += taps[numTaps - 1 - k] * x[k];
+                output[numOut++] = sum;
+            }
+        }
+        return numOut;
+    }
+
+    // model rate -> host rate; consumes the numInput samples from the matching decimate() call
+    void interpolate(const float* input, int numInput, float* output, int numSamples) {
+        int next = 0;
+        for (int i = 0; i < numSamples; ++i) {
+            if (interpolatorPhase == 0) {
+                // take the oldest pending sample, then queue this block's input behind it
+                float y;
+                if (pendingCount > 0) {
+                    y = pending[0];
+                    pending[0] = pending[1];
+                    --pendingCount;
+                } else {
+                    y = next < numInput ? input[next++] : 0.0f;
+                }
+                interpolatorHistory[interpolatorPos] = y;
+                interpolatorHistory[interpolatorPos + numHalfRateTaps] = y;
+                if (++interpolatorPos == numHalfRateTaps) interpolatorPos = 0;
+            }
+
+            // zero-stuffed input: only every other tap meets a sample
+            const float* y = interpolatorHistory.data() + interpolatorPos; // oldest first
+            float sum = 0.0f;
+            for (int j = 0, k = interpolatorPhase; k < numTaps; ++j, k += 2)
+                sum += taps[k] * y[numHalfRateTaps - 1 - j];
+            output[i] = 2.0f * sum;
+
+            interpolatorPhase ^= 1;
+        }
+        // whatever this block produced but didn't consume waits for the next one
+        while (next < numInput && pendingCount < (int)pending.size())
+            pending[pendingCount++] = input[next++];
+    }
+
+private:
+    std::array<float, numTaps> taps;
+    std::array<float, 2 * numTaps> decimatorHistory;
+    std::array<float, 2 * numHalfRateTaps> interpolatorHistory;
+    std::array<float, 2> pending;
+    int decimatorPos = 0;
+    int interpolatorPos = 0;
+    int decimatorPhase = 0;
+    int interpolatorPhase = 0;
+    int pendingCount = 0;
+};
@@ -0,0 +1,66 @@
+#include "InferenceScheduler.h"
+#include "AsyncInferenceWorker.h"
+#include <algorithm>
+
+class InferenceScheduler::Thread : public juce::Thread {
+public:
+    Thread(InferenceScheduler& s, int i)
+        : juce::Thread("Alt Denoiser Inference " + juce::String(i)), scheduler(s), index(i) {}
+    ~Thread() override { stopThread(2000); }
+
+    void run() override {
+        while (!threadShouldExit()) {
+            // signalled by push(); the timeout only matters if a wake-up was missed
+            if (!scheduler.serviceAll(index))
+                scheduler.wakeup.wait(idleTimeoutMs);
+        }
+    }
+
+private:
+    static constexpr int idleTimeoutMs = 100;
+
+    InferenceScheduler& scheduler;
+    int index;
+};
+
+InferenceScheduler::InferenceScheduler() {
+    // roughly half the machine, the rest is the host's; no affinity, the OS knows which cores
+    // are free, which are SMT siblings and which are efficiency cores better than we do
+    int numThreads = juce::jlimit(1, 8, juce::SystemStats::getNumCpus() / 2);
+
+    for (int i = 0; i < numThreads; ++i) {
+        threads.push_back(std::make_unique<Thread>(*this, i));
+        threads.back()->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(8).withPeriodMs(10.0));
+    }
+}
+
+InferenceScheduler::~InferenceScheduler() {
+    for (auto& thread : threads)
+        thread->signalThreadShouldExit();
+    wakeup.signal((int)threads.size());
+    threads.clear();
+}
+
+void InferenceScheduler::add(AsyncInferenceWorker* worker) {
+    const juce::ScopedWriteLock sl(workersLock);
+    if (std::find(workers.begin(), workers.end(), worker) == workers.end())
+        workers.push_back(worker);
+}
+
+void InferenceScheduler::remove(AsyncInferenceWorker* worker) {
+    const juce::ScopedWriteLock sl(workersLock);
+    workers.erase(std::remove(workers.begin(), workers.end(), worker), workers.end());
+}
+
+bool InferenceScheduler::serviceAll(int startIndex) {
+    const juce::ScopedReadLock sl(workersLock);
+
+    bool didWork = false;
+    int numWorkers = (int)workers.size();
+    // threads start at different offsets so they don't all queue up on the same worker
+    for (int i = 0; i < numWorkers; ++i) {
+        auto* worker = workers[(startIndex + i) % numWorkers];
+        didWork = worker->service() || didWork;
+    }
+    return didWork;
+}
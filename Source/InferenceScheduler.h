@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "WakeSemaphore.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class AsyncInferenceWorker;
+
+// Process-wide pool of inference threads shared by every plugin instance.
+// Instead of one thread per channel per instance, a bounded set of pinned threads
+// walks all registered workers and runs every frame that is ready on each of them.
+// Idle threads sleep on a semaphore that workers signal as soon as a hop is complete,
+// so a hop starts without polling delay and idle threads cost nothing.
+// Hold it through juce::SharedResourcePointer<InferenceScheduler>.
+class InferenceScheduler {
+public:
+    InferenceScheduler();
+    ~InferenceScheduler();
+
+    // not real-time safe; remove() waits until no thread is inside the worker
+    void add(AsyncInferenceWorker* worker);
+    void remove(AsyncInferenceWorker* worker);
+
+    int getNumThreads() const { return (int)threads.size(); }
+
+    // any thread, real-time safe: a hop is ready somewhere, wake a thread for it
+    void wake() { wakeup.notify(); }
+
+private:
+    class Thread;
+
+    // one pass over all workers, returns false if there was nothing to do
+    bool serviceAll(int startIndex);
+
+    juce::ReadWriteLock workersLock;
+    std::vector<AsyncInferenceWorker*> workers;
+    std::vector<std::unique_ptr<Thread>> threads;
+    WakeSemaphore wakeup;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InferenceScheduler)
+};
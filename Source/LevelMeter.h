@@ -0,0 +1,239 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define ALT_DENOISER_METER_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define ALT_DENOISER_METER_NEON 1
+#endif
+
+// Per-channel peak and RMS of the plugin's input and output, plus the gain reduction.
+// Neither side costs a pass of its own: the input is measured by the dry delay as it copies
+// it, the output by the vectorised dry/wet mix as it writes it, which also reads the
+// latency-aligned dry signal, so the gain reduction compares matching samples.
+// Everything is published through atomics: the editor never locks, the audio thread never waits.
+class LevelMeter {
+public:
+    static constexpr int maxChannels = 8;
+
+    struct Levels {
+        float peak = 0.0f; // highest |sample| since the last read
+        float rms = 0.0f;  // smoothed per block
+    };
+
+    // while stopped
+    void reset(int newNumChannels) {
+        numChannels.store(juce::jlimit(0, maxChannels, newNumChannels));
+        for (auto* side : { &input, &output })
+            for (auto& channel : *side) {
+                channel.peak.store(0.0f);
+                channel.rms.store(0.0f);
+            }
+        gainReductionDb.store(0.0f);
+    }
+
+    int getNumChannels() const { return numChannels.load(); }
+
+    // audio thread: one input channel's block, measured by whoever copied it
+    void pushInput(int channel, float peak, float sumSquares, int numSamples) {
+        if (channel < numChannels.load(std::memory_order_relaxed))
+            publish(input[(size_t)channel], peak, sumSquares, numSamples);
+    }
+
+    // audio thread, after processing, when the output is final already; dry is the input
+    // delayed by the reported latency
+    void pushOutput(const juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& dry, int numChannels, int numSamples) {
+        const int n = juce::jmin(juce::jmin(numChannels, this->numChannels.load(std::memory_order_relaxed)),
+                                 buffer.getNumChannels(), dry.getNumChannels());
+        double outTotal = 0.0, dryTotal = 0.0;
+        for (int ch = 0; ch < n; ++ch) {
+            auto stats = measure<true>(buffer.getReadPointer(ch), dry.getReadPointer(ch), numSamples);
+            publish(output[(size_t)ch], stats.peak, stats.sumSquares, numSamples);
+            outTotal += stats.sumSquares;
+            dryTotal += stats.drySumSquares;
+        }
+        publishReduction(outTotal, dryTotal, numSamples);
+    }
+
+    // audio thread, after processing: blends the wet signal in buffer with the aligned dry one,
+    // dry + gain * (wet - dry), and measures the result in the same pass. gains holds one gain
+    // per sample, or is nullptr for the constant gain
+    void mixOutput(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& dry, int numChannels,
+                   const float* gains, float gain, int numSamples) {
+        const int n = juce::jmin(juce::jmin(numChannels, this->numChannels.load(std::memory_order_relaxed)),
+                                 buffer.getNumChannels(), dry.getNumChannels());
+        double outTotal = 0.0, dryTotal = 0.0;
+        for (int ch = 0; ch < n; ++ch) {
+            auto stats = gains != nullptr ? mix<true>(buffer.getWritePointer(ch), dry.getReadPointer(ch), gains, 0.0f, numSamples)
+                                          : mix<false>(buffer.getWritePointer(ch), dry.getReadPointer(ch), nullptr, gain, numSamples);
+            publish(output[(size_t)ch], stats.peak, stats.sumSquares, numSamples);
+            outTotal += stats.sumSquares;
+            dryTotal += stats.drySumSquares;
+        }
+        publishReduction(outTotal, dryTotal, numSamples);
+    }
+
+    // editor
+    Levels readInput(int channel) { return read(input[(size_t)juce::jlimit(0, maxChannels - 1, channel)]); }
+    Levels readOutput(int channel) { return read(output[(size_t)juce::jlimit(0, maxChannels - 1, channel)]); }
+    float getGainReductionDb() const { return gainReductionDb.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr float smoothAlpha = 0.5f;
+
+    struct Channel {
+        std::atomic<float> peak { 0.0f };
+        std::atomic<float> rms { 0.0f };
+    };
+
+    struct Stats {
+        float peak = 0.0f;
+        float sumSquares = 0.0f;
+        float drySumSquares = 0.0f;
+    };
+
+    // peak and energy in a single pass; with withDry the dry energy too, from the same loop
+    template <bool withDry>
+    static Stats measure(const float* data, const float* dry, int numSamples) {
+        Stats stats;
+        int i = 0;
+#if ALT_DENOISER_METER_SSE
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peak = _mm_setzero_ps(), sum = _mm_setzero_ps(), drySum = _mm_setzero_ps();
+        for (; i + 4 <= numSamples; i += 4) {
+            __m128 x = _mm_loadu_ps(data + i);
+            peak = _mm_max_ps(peak, _mm_and_ps(x, absMask));
+            sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+            if constexpr (withDry) {
+                __m128 d = _mm_loadu_ps(dry + i);
+                drySum = _mm_add_ps(drySum, _mm_mul_ps(d, d));
+            }
+        }
+        alignas(16) float lanes[3][4];
+        _mm_store_ps(lanes[0], peak);
+        _mm_store_ps(lanes[1], sum);
+        _mm_store_ps(lanes[2], drySum);
+#elif ALT_DENOISER_METER_NEON
+        float32x4_t peak = vdupq_n_f32(0.0f), sum = vdupq_n_f32(0.0f), drySum = vdupq_n_f32(0.0f);
+        for (; i + 4 <= numSamples; i += 4) {
+            float32x4_t x = vld1q_f32(data + i);
+            peak = vmaxq_f32(peak, vabsq_f32(x));
+            sum = vmlaq_f32(sum, x, x);
+            if constexpr (withDry) {
+                float32x4_t d = vld1q_f32(dry + i);
+                drySum = vmlaq_f32(drySum, d, d);
+            }
+        }
+        float lanes[3][4];
+        vst1q_f32(lanes[0], peak);
+        vst1q_f32(lanes[1], sum);
+        vst1q_f32(lanes[2], drySum);
+#else
+        float lanes[3][4] = {};
+#endif
+        for (int lane = 0; lane < 4; ++lane) {
+            stats.peak = juce::jmax(stats.peak, lanes[0][lane]);
+            stats.sumSquares += lanes[1][lane];
+            stats.drySumSquares += lanes[2][lane];
+        }
+        for (; i < numSamples; ++i) {
+            stats.peak = juce::jmax(stats.peak, std::abs(data[i]));
+            stats.sumSquares += data[i] * data[i];
+            if constexpr (withDry) stats.drySumSquares += dry[i] * dry[i];
+        }
+        return stats;
+    }
+
+    // wet = dry + g * (wet - dry), g from gains with ramp, else gain; then as measure<true>
+    template <bool ramp>
+    static Stats mix(float* wet, const float* dry, const float* gains, float gain, int numSamples) {
+        Stats stats;
+        int i = 0;
+#if ALT_DENOISER_METER_SSE
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 g = _mm_set1_ps(gain);
+        __m128 peak = _mm_setzero_ps(), sum = _mm_setzero_ps(), drySum = _mm_setzero_ps();
+        for (; i + 4 <= numSamples; i += 4) {
+            if constexpr (ramp) g = _mm_loadu_ps(gains + i);
+            __m128 d = _mm_loadu_ps(dry + i);
+            __m128 x = _mm_add_ps(d, _mm_mul_ps(g, _mm_sub_ps(_mm_loadu_ps(wet + i), d)));
+            _mm_storeu_ps(wet + i, x);
+            peak = _mm_max_ps(peak, _mm_and_ps(x, absMask));
+            sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+            drySum = _mm_add_ps(drySum, _mm_mul_ps(d, d));
+        }
+        alignas(16) float lanes[3][4];
+        _mm_store_ps(lanes[0], peak);
+        _mm_store_ps(lanes[1], sum);
+        _mm_store_ps(lanes[2], drySum);
+#elif ALT_DENOISER_METER_NEON
+        float32x4_t g = vdupq_n_f32(gain);
+        float32x4_t peak = vdupq_n_f32(0.0f), sum = vdupq_n_f32(0.0f), drySum = vdupq_n_f32(0.0f);
+        for (; i + 4 <= numSamples; i += 4) {
+            if constexpr (ramp) g = vld1q_f32(gains + i);
+            float32x4_t d = vld1q_f32(dry + i);
+            float32x4_t x = vmlaq_f32(d, g, vsubq_f32(vld1q_f32(wet + i), d));
+            vst1q_f32(wet + i, x);
+            peak = vmaxq_f32(peak, vabsq_f32(x));
+            sum = vmlaq_f32(sum, x, x);
+            drySum = vmlaq_f32(drySum, d, d);
+        }
+        float lanes[3][4];
+        vst1q_f32(lanes[0], peak);
+        vst1q_f32(lanes[1], sum);
+        vst1q_f32(lanes[2], drySum);
+#else
+        float lanes[3][4] = {};
+#endif
+        for (int lane = 0; lane < 4; ++lane) {
+            stats.peak = juce::jmax(stats.peak, lanes[0][lane]);
+            stats.sumSquares += lanes[1][lane];
+            stats.drySumSquares += lanes[2][lane];
+        }
+        for (; i < numSamples; ++i) {
+            const float d = dry[i];
+            const float x = d + (ramp ? gains[i] : gain) * (wet[i] - d);
+            wet[i] = x;
+            stats.peak = juce::jmax(stats.peak, std::abs(x));
+            stats.sumSquares += x * x;
+            stats.drySumSquares += d * d;
+        }
+        return stats;
+    }
+
+    void publishReduction(double outTotal, double dryTotal, int numSamples) {
+        // silence on both sides says nothing about the reduction, let it fall back to zero
+        float reduction = dryTotal > 1.0e-10 * numSamples
+                        ? (float)juce::jmax(0.0, 10.0 * std::log10(dryTotal / juce::jmax(outTotal, 1.0e-20)))
+                        : 0.0f;
+        float old = gainReductionDb.load(std::memory_order_relaxed);
+        gainReductionDb.store(old * (1.0f - smoothAlpha) + reduction * smoothAlpha, std::memory_order_relaxed);
+    }
+
+    static void publish(Channel& channel, float peak, float sumSquares, int numSamples) {
+        // the editor resets the peak when it reads it, so keep the highest one until then
+        float held = channel.peak.load(std::memory_order_relaxed);
+        while (peak > held && !channel.peak.compare_exchange_weak(held, peak, std::memory_order_relaxed)) {}
+        float rms = numSamples > 0 ? std::sqrt(sumSquares / (float)numSamples) : 0.0f;
+        float old = channel.rms.load(std::memory_order_relaxed);
+        channel.rms.store(old * (1.0f - smoothAlpha) + rms * smoothAlpha, std::memory_order_relaxed);
+    }
+
+    static Levels read(Channel& channel) {
+        Levels levels;
+        levels.peak = channel.peak.exchange(0.0f, std::memory_order_relaxed);
+        levels.rms = channel.rms.load(std::memory_order_relaxed);
+        return levels;
+    }
+
+    std::atomic<int> numChannels { 0 };
+    std::array<Channel, maxChannels> input;
+    std::array<Channel, maxChannels> output;
+    std::atomic<float> gainReductionDb { 0.0f };
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+// Keeps a channel inside its real-time budget when the machine runs out of CPU.
+// It steps down one tier only when a deadline was really missed: the async output ran dry, or
+// a host block overran. Every model hop is also timed against a per-hop budget, which the owner
+// derives from the host's deadline and keeps updated as it measures the work around the model;
+// the smoothed cost against it only decides when there is headroom to step back up. The tiers:
+//   full      - every hop goes through the model (the silence gate as the user set it)
+//   eagerGate - the gate runs regardless, with its floor raised, so quieter hops skip the model
+//   fallback  - no model: the delayed input at the model's recent broadband gain while that is
+//               fresh, then at a gain from the hop's energy over the noise floor
+// In fallback one hop in probeInterval still runs the model, its output discarded, to measure.
+// It steps back up one tier at a time after a quiet spell, which doubles each time a step up
+// is followed by a quick step down, so a machine that is just barely too slow doesn't flap.
+// Runs wherever inference runs; only noteUnderrun() may be called from another thread.
+class LoadGovernor {
+public:
+    enum class Tier { full, eagerGate, fallback };
+    // what the hops were spent on, for telemetry
+    enum class Counter { full, eagerGate, heldGain, expander };
+    static constexpr int numCounters = 4; // Telemetry::numTierCounters
+
+    static constexpr float eagerGateBoostDb = 20.0f;
+    static constexpr int probeInterval = 25;   // hops
+    static constexpr int heldGainHops = 20;     // the model's gain is trusted this long, 200 ms
+
+    // budgetMs: what one hop may cost; <= 0 never degrades
+    void reset(double newBudgetMs) {
+        budgetMs = newBudgetMs > 0.0 ? juce::jmax(minBudgetMs, newBudgetMs) : 0.0;
+        tier = Tier::full;
+        costMs = 0.0;
+        hopsInTier = 0;
+        hopsSinceStepUp = 1 << 30;
+        upHoldHops = minUpHoldHops;
+        hopsSinceInference = 0;
+        inEnergy = outEnergy = 0.0f;
+        underrun.store(false);
+    }
+
+    // the deadline moved, keeping the tier; ignored while disabled
+    void setBudget(double newBudgetMs) {
+        if (isEnabled()) budgetMs = juce::jmax(minBudgetMs, newBudgetMs);
+    }
+
+    Tier getTier() const { return tier; }
+    bool isEnabled() const { return budgetMs > 0.0; }
+
+    // any thread: the output ran dry or the host block overran; steps down on the next hop
+    void noteUnderrun() { underrun.store(true, std::memory_order_relaxed); }
+
+    // once per hop, before the gate is asked; true if a fallback hop should probe the model
+    bool beginHop() {
+        ++hopsInTier;
+        if (hopsSinceStepUp < (1 << 30)) ++hopsSinceStepUp;
+        if (!isEnabled()) return false;
+        // a long steady spell at full earns back the quicker recovery
+        if (tier == Tier::full && hopsInTier % (4 * upHoldHops) == 0)
+            upHoldHops = juce::jmax(minUpHoldHops, upHoldHops / 2);
+        // a lighter tier gets a moment to show before the next miss counts against it
+        if (underrun.exchange(false, std::memory_order_relaxed) && tier != Tier::fallback
+            && hopsInTier >= minHopsPerTier)
+            stepDown();
+        if (tier == Tier::fallback) {
+            ++hopsSinceInference;
+            return hopsInTier % probeInterval == 0;
+        }
+        return false;
+    }
+
+    // after the model ran a hop, with what it cost
+    void recordInference(double ms) {
+        if (!isEnabled()) return;
+        // the sparse probes weigh most
+        costMs += (tier == Tier::fallback ? probeAlpha : costAlpha) * (ms - costMs);
+
+        // an estimate over budget alone is no miss: the driver's slack may well absorb it
+        if (costMs < upThreshold * budgetMs && tier != Tier::full && hopsInTier >= upHoldHops)
+            stepUp();
+    }
+
+    // after an inferred hop: energy in and out, for the held gain
+    void recordGain(float inputEnergy, float outputEnergy) {
+        inEnergy += gainAlpha * (inputEnergy - inEnergy);
+        outEnergy += gainAlpha * (outputEnergy - outEnergy);
+        hopsSinceInference = 0;
+    }
+
+    // gain for a fallback hop, never below floorGain (the attenuation limit)
+    float getFallbackGain(float hopEnergyDb, float noiseDb, float floorGain, Counter& used) const {
+        if (hopsSinceInference <= heldGainHops && inEnergy > 1.0e-12f) {
+            used = Counter::heldGain;
+            return juce::jlimit(floorGain, 1.0f, std::sqrt(outEnergy / inEnergy));
+        }
+        used = Counter::expander;
+        if (noiseDb <= -120.0f) return 1.0f; // no idea what the noise is: pass it through
+        // power subtraction, broadband: what is left of the hop once the noise is taken out
+        float noiseRatio = std::pow(10.0f, 0.1f * (noiseDb - hopEnergyDb));
+        return juce::jlimit(floorGain, 1.0f, std::sqrt(juce::jmax(0.0f, 1.0f - noiseRatio)));
+    }
+
+    void count(Counter counter, int numHops) {
+        counters[(size_t)counter].fetch_add((juce::uint64)numHops, std::memory_order_relaxed);
+    }
+    juce::uint64 getCount(Counter counter) const { return counters[(size_t)counter].load(); }
+
+private:
+    static constexpr double costAlpha = 0.1;
+    static constexpr double probeAlpha = 0.5;
+    static constexpr float gainAlpha = 0.3f;
+    static constexpr double upThreshold = 0.5;
+    static constexpr double minBudgetMs = 0.01; // a deadline eaten up by other work never steps up
+    static constexpr int minHopsPerTier = 10;
+    static constexpr int minUpHoldHops = 100;   // 1 s
+    static constexpr int maxUpHoldHops = 3200;  // 32 s
+
+    void stepDown() {
+        // stepped up too early: wait longer next time
+        if (hopsSinceStepUp < 2 * upHoldHops)
+            upHoldHops = juce::jmin(maxUpHoldHops, 2 * upHoldHops);
+        tier = tier == Tier::full ? Tier::eagerGate : Tier::fallback;
+        hopsInTier = 0;
+    }
+
+    void stepUp() {
+        tier = tier == Tier::fallback ? Tier::eagerGate : Tier::full;
+        hopsInTier = 0;
+        hopsSinceStepUp = 0;
+    }
+
+    double budgetMs = 0.0;
+    Tier tier = Tier::full;
+    double costMs = 0.0;
+    int hopsInTier = 0;
+    int hopsSinceStepUp = 1 << 30;
+    int upHoldHops = minUpHoldHops;
+    int hopsSinceInference = 0;
+    float inEnergy = 0.0f;
+    float outEnergy = 0.0f;
+    std::atomic<bool> underrun { false };
+    std::array<std::atomic<juce::uint64>, numCounters> counters {};
+};
@@ -0,0 +1,174 @@
+#include "ModelCache.h"
+#if ALT_DENOISER_EMBED_MODEL
+#include "BinaryData.h"
+#endif
+
+const std::array<ModelCache::Variant, ModelCache::numVariants> ModelCache::variants { {
+    { "DeepFilterNet3",     "DeepFilterNet3_onnx.tar.gz",     2, 48000 },
+    { "DeepFilterNet3 LL",  "DeepFilterNet3_ll_onnx.tar.gz",  0, 48000 }, // no lookahead, less delay
+    { "DeepFilterNet2",     "DeepFilterNet2_onnx.tar.gz",     2, 48000 },
+    { "DeepFilterNet3 16k", "DeepFilterNet3_16k_onnx.tar.gz", 2, 16000 }, // narrowband, user-installed only
+} };
+
+int ModelCache::getMaxLookaheadHops() {
+    int hops = 0;
+    for (const auto& variant : variants)
+        hops = juce::jmax(hops, variant.lookaheadHops);
+    return hops;
+}
+
+ModelCache::ModelCache() {
+}
+
+ModelCache::~ModelCache() {
+    for (auto& states : spareStates)
+        for (auto* state : states)
+            df_free(state);
+}
+
+namespace {
+    juce::File getCacheDirectory() {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                   .getChildFile("Alt Denoiser").getChildFile("Models");
+    }
+
+    // a header check, the gzip magic and nothing else; df_create reads the archive itself
+    bool isModelArchive(const juce::File& file) {
+        juce::FileInputStream in(file);
+        juce::uint8 bytes[2] = {};
+        return in.openedOk() && in.read(bytes, 2) == 2 && bytes[0] == 0x1f && bytes[1] == 0x8b; // gzip
+    }
+
+#if ALT_DENOISER_EMBED_MODEL
+    // FNV-1a, only used to tell model blobs apart
+    juce::uint64 hashModelData(const char* data, int size) {
+        juce::uint64 hash = 14695981039346656037ull;
+        for (int i = 0; i < size; ++i) {
+            hash ^= (juce::uint8)data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+#endif
+}
+
+juce::File ModelCache::getModelFile(int variant)
+{
+    variant = juce::jlimit(0, numVariants - 1, variant);
+    const juce::ScopedLock sl(lock);
+    if (modelFiles[(size_t)variant] != juce::File()) return modelFiles[(size_t)variant];
+
+    // an installed archive wins: nothing is copied, and the embedded bytes are never paged in
+    auto file = findInstalledModel(variant);
+    if (file == juce::File() && variant == defaultVariant)
+        file = unpackEmbeddedModel();
+    if (file == juce::File())
+        DBG("Model not found: " + juce::String(variants[(size_t)variant].fileName));
+    else
+        modelFiles[(size_t)variant] = file;
+    return file;
+}
+
+juce::File ModelCache::findInstalledModel(int variant) const {
+    juce::Array<juce::File> folders;
+    auto envDir = juce::SystemStats::getEnvironmentVariable("ALT_DENOISER_MODEL_DIR", {});
+    if (juce::File::isAbsolutePath(envDir))
+        folders.add(juce::File(envDir));
+    folders.add(getCacheDirectory());
+    folders.add(juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory().getChildFile("Models"));
+
+    for (const auto& folder : folders) {
+        auto file = folder.getChildFile(variants[(size_t)variant].fileName);
+        if (isModelArchive(file)) return file;
+    }
+    return {};
+}
+
+juce::File ModelCache::unpackEmbeddedModel()
+{
+#if ALT_DENOISER_EMBED_MODEL
+    const char* modelData = AltDenoiserBinaryData::DeepFilterNet3_onnx_tar_gz;
+    const int modelSize   = AltDenoiserBinaryData::DeepFilterNet3_onnx_tar_gzSize;
+
+    if (modelSize <= 0 || modelData == nullptr)
+    {
+        DBG("Embedded model data invalid or missing");
+        return {};
+    }
+
+    // keyed by content, so the file survives across launches and a new model never reuses a stale one
+    auto cacheDir = getCacheDirectory();
+    auto cachedModel = cacheDir.getChildFile("DeepFilterNet3_onnx_"
+                        + juce::String::toHexString((juce::int64)hashModelData(modelData, modelSize)) + ".tar.gz");
+
+    if (cachedModel.existsAsFile() && cachedModel.getSize() == modelSize)
+        return cachedModel;
+
+    if (!cacheDir.createDirectory()) {
+        // fall back to the temp dir
+        cachedModel = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile(cachedModel.getFileName());
+    }
+
+    {
+        // write next to the target and move it into place, other processes may be loading it
+        juce::TemporaryFile temp(cachedModel);
+        {
+            juce::FileOutputStream stream(temp.getFile());
+            if (!stream.openedOk())
+            {
+                DBG("Failed to open model cache file");
+                return {};
+            }
+            stream.write(modelData, modelSize);
+            stream.flush();
+        }
+        if (!temp.overwriteTargetFileWithTemporary())
+        {
+            DBG("Failed to move model into the cache");
+            return {};
+        }
+    }
+    return cachedModel;
+#else
+    return {};
+#endif
+}
+
+DFState* ModelCache::acquireState(int variant) {
+    variant = juce::jlimit(0, numVariants - 1, variant);
+    DFState* recycled = nullptr;
+    {
+        const juce::ScopedLock sl(lock);
+        auto& spares = spareStates[(size_t)variant];
+        if (!spares.empty()) {
+            recycled = spares.back();
+            spares.pop_back();
+        }
+    }
+    if (recycled != nullptr) {
+        // df.h has no reset: push the last stream's audio out of the STFT buffers and
+        // lookahead, and let the recurrent state settle on silence
+        std::vector<float> silence(df_get_frame_length(recycled), 0.0f), output(silence.size());
+        for (int i = 0; i < flushHops; ++i)
+            df_process_frame(recycled, silence.data(), output.data());
+        return recycled;
+    }
+
+    auto file = getModelFile(variant);
+    if (file == juce::File()) return nullptr;
+    return df_create(file.getFullPathName().toRawUTF8(), 100.0f, nullptr);
+}
+
+void ModelCache::releaseState(int variant, DFState* state) {
+    if (state == nullptr) return;
+    variant = juce::jlimit(0, numVariants - 1, variant);
+
+    const juce::ScopedLock sl(lock);
+    auto& spares = spareStates[(size_t)variant];
+    if ((int)spares.size() < maxSpareStates) {
+        // its atten limit is set by the next owner, its streaming state flushed by acquireState()
+        spares.push_back(state);
+        return;
+    }
+    df_free(state);
+}
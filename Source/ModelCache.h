@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <vector>
+#include "df.h"
+
+// Process-wide model store shared by every plugin instance.
+// Model archives are loaded straight from disk: ALT_DENOISER_MODEL_DIR, the user's
+// "Alt Denoiser/Models" folder, or a Models folder next to the plugin binary. Only when
+// none has the archive is the embedded DeepFilterNet3 unpacked once into a content-hashed
+// file and reused across launches.
+// Weights are not shared: df.h can only create a state from the archive, so every live
+// DFState is a full df_create with its own copy. What is shared is the archive lookup and
+// recycling: states of closed instances are kept per variant and handed to the next one,
+// which then skips df_create. A recycled state is first run through flushHops hops of
+// silence, so nothing of the previous stream is heard; its recurrent and normalisation
+// state end up where silence leaves them, close to but not bit-identical with a fresh one.
+// Hold it through juce::SharedResourcePointer<ModelCache>.
+class ModelCache {
+public:
+    struct Variant {
+        const char* name;
+        const char* fileName; // as shipped in DeepFilterNet's models/ folder
+        int lookaheadHops;    // on top of the one-hop STFT delay
+        int sampleRate;       // the rate it was trained at; df.h can't tell
+    };
+    static constexpr int numVariants = 4;
+    static const std::array<Variant, numVariants> variants;
+    static constexpr int defaultVariant = 0;
+    static int getMaxLookaheadHops();
+
+    ModelCache();
+    ~ModelCache();
+
+    // path of the variant's archive, or an invalid File if there is none
+    juce::File getModelFile(int variant);
+
+    // not real-time safe: may call df_create, or flush a recycled state
+    DFState* acquireState(int variant);
+    void releaseState(int variant, DFState* state);
+
+private:
+    static constexpr int maxSpareStates = 8;
+    static constexpr int flushHops = 100; // 1 s, about what the model's feature normalisation needs
+
+    juce::File findInstalledModel(int variant) const;
+    juce::File unpackEmbeddedModel();
+
+    juce::CriticalSection lock;
+    std::array<juce::File, numVariants> modelFiles;
+    std::array<std::vector<DFState*>, numVariants> spareStates;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModelCache)
+};
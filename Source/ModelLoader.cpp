@@ -0,0 +1,75 @@
+#include "ModelLoader.h"
+
+ModelLoader::ModelLoader(std::vector<std::unique_ptr<ChannelProcessor>>& c, std::function<void()> h)
+    : juce::Thread("Alt Denoiser Model Loader"), channels(c), housekeeping(std::move(h)) {
+    startThread(juce::Thread::Priority::low);
+}
+
+ModelLoader::~ModelLoader() {
+    signalThreadShouldExit();
+    wakeup.signal(1);
+    // df_create can't be interrupted, give it time to finish
+    stopThread(30000);
+}
+
+void ModelLoader::request(int numChannels) {
+    numChannels = juce::jlimit(0, (int)channels.size(), numChannels);
+    if (numChannels <= requestedChannels.load()) return;
+
+    requestedChannels.store(numChannels);
+    if (state.load() != State::failed)
+        state.store(State::loading);
+    wakeup.notify();
+}
+
+void ModelLoader::run() {
+    int doneChannels = -1;
+    int doneVariant = -1;
+    while (!threadShouldExit()) {
+        if (housekeeping)
+            housekeeping();
+        int wanted = requestedChannels.load();
+        int variant = requestedVariant.load();
+        if (wanted == doneChannels && variant == doneVariant) {
+            wakeup.wait(-1);
+            continue;
+        }
+        state.store(State::loading);
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        bool loaded = load(wanted, variant);
+        // a session may ask for a variant that isn't installed on this machine: keep denoising
+        if (!loaded && variant != ModelCache::defaultVariant && !threadShouldExit()) {
+            DBG("Falling back to " + juce::String(ModelCache::variants[ModelCache::defaultVariant].name));
+            loaded = load(wanted, ModelCache::defaultVariant);
+        }
+        doneChannels = wanted;
+        doneVariant = variant;
+
+        if (loaded)
+            loadTimeMs.store(juce::Time::getMillisecondCounterHiRes() - start);
+        if (!loaded)
+            state.store(State::failed);
+        else if (wanted == requestedChannels.load() && variant == requestedVariant.load())
+            state.store(State::ready);
+        attemptFinished.signal();
+    }
+}
+
+bool ModelLoader::waitUntilLoaded(int timeoutMs) {
+    const auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32)juce::jmax(0, timeoutMs);
+    while (state.load() == State::loading) {
+        const auto now = juce::Time::getMillisecondCounter();
+        if (now >= deadline) return false;
+        attemptFinished.wait((int)(deadline - now));
+    }
+    return state.load() == State::ready;
+}
+
+bool ModelLoader::load(int numChannels, int variant) {
+    // free for channels that already have it
+    for (int ch = 0; ch < numChannels && !threadShouldExit(); ++ch)
+        if (!channels[ch]->initialize(variant)) return false;
+    loadedVariant.store(variant);
+    return true;
+}
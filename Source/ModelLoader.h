@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "ChannelProcessor.h"
+#include "WakeSemaphore.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Loads the model states of the first N channels on a background thread,
+// so neither the constructor nor prepareToPlay ever wait for df_create.
+// The loaded states wait as pending models until the audio thread swaps them in.
+// Between loads the thread also runs the owner's housekeeping: work the audio thread hands
+// off because it must not take locks, like telling the host about a new latency.
+class ModelLoader : private juce::Thread {
+public:
+    enum class State { loading, ready, failed };
+
+    // the channel list must not change size while the loader exists; housekeeping runs on the
+    // loader thread after every wake()
+    explicit ModelLoader(std::vector<std::unique_ptr<ChannelProcessor>>& channels,
+                         std::function<void()> housekeeping = {});
+    ~ModelLoader() override;
+
+    // any thread: make sure the first numChannels channels get a model
+    void request(int numChannels);
+    // any thread, also the audio thread: wakes the loader only when the variant changes
+    void requestVariant(int variant) {
+        if (requestedVariant.exchange(variant) != variant)
+            wakeup.notify();
+    }
+    // any thread, also the audio thread: run the housekeeping soon, after the current load
+    void wake() { wakeup.notify(); }
+
+    State getState() const { return state.load(); }
+    // not real-time safe: blocks until the requested models are loaded, have failed, or
+    // timeoutMs has passed; true if they are loaded
+    bool waitUntilLoaded(int timeoutMs);
+    // what the channels were last given; the default model if the requested one is not installed
+    int getLoadedVariant() const { return loadedVariant.load(); }
+    // wall-clock time of the last load, 0 until one has finished; the editor shows it once it changes
+    double getLoadTimeMs() const { return loadTimeMs.load(); }
+
+private:
+    void run() override;
+
+    std::vector<std::unique_ptr<ChannelProcessor>>& channels;
+    const std::function<void()> housekeeping;
+    bool load(int numChannels, int variant);
+
+    std::atomic<int> requestedChannels { 0 };
+    std::atomic<int> requestedVariant { ModelCache::defaultVariant };
+    std::atomic<int> loadedVariant { -1 };
+    std::atomic<State> state { State::loading };
+    std::atomic<double> loadTimeMs { 0.0 };
+    juce::WaitableEvent attemptFinished;
+    // the loader sleeps on this between requests, not on juce::Thread::wait(), which locks
+    WakeSemaphore wakeup;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModelLoader)
+};
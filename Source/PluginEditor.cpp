@@ -37,17 +37,39 @@ AltDenoiserEditor::AltDenoiserEditor(AltDenoiserProcessor& p, juce::AudioProcess
             ); };
 
 
+    // the last few seconds of the audio path, for a dropout that just happened
+    addAndMakeVisible(traceButton);
+    traceButton.setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
+    traceButton.setColour(juce::TextButton::textColourOffId, juce::Colours::grey);
+    traceButton.setTooltip("Save a timeline of the last few seconds");
+    traceButton.onClick = [this] { audioProcessor.requestFlightTrace(); };
+    shownTrace = audioProcessor.getLastFlightTrace();
+
     addAndMakeVisible(inputMeter);
     addAndMakeVisible(outputMeter);
+    addAndMakeVisible(reductionMeter);
+    addAndMakeVisible(spectrogram);
+    audioProcessor.getSpectrum().setActive(true);
+
+    statusLabel.setJustificationType(juce::Justification::centred);
+    statusLabel.setFont(juce::Font(12.0f));
+    statusLabel.setColour(juce::Label::textColourId, juce::Colour(0xffff9900));
+    addAndMakeVisible(statusLabel);
+
+    telemetryLabel.setJustificationType(juce::Justification::centred);
+    telemetryLabel.setFont(juce::Font(10.0f));
+    telemetryLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+    addAndMakeVisible(telemetryLabel);
 
     startTimerHz(60);
-    setSize(460, 320); 
+    setSize(460, 420); 
 }
 
 AltDenoiserEditor::~AltDenoiserEditor()
 {
     setLookAndFeel(nullptr);
     stopTimer();
+    audioProcessor.getSpectrum().setActive(false);
 }
 
 void AltDenoiserEditor::paint(juce::Graphics& g)
@@ -61,9 +83,13 @@ void AltDenoiserEditor::paint(juce::Graphics& g)
 void AltDenoiserEditor::resized()
 {
     auto area = getLocalBounds();
+    // 0. spectrogram along the bottom, the rest keeps its layout above it
+    spectrogram.setBounds(area.removeFromBottom(100).reduced(20, 4));
+
     // 1. meter
-    inputMeter.setBounds(20, 50, 70, getHeight() - 80); 
-    outputMeter.setBounds(getWidth() - 90, 50, 70, getHeight() - 80);
+    inputMeter.setBounds(20, 50, 70, area.getHeight() - 80); 
+    outputMeter.setBounds(getWidth() - 90, 50, 70, area.getHeight() - 80);
+    reductionMeter.setBounds(getWidth() - 124, 50, 34, area.getHeight() - 80);
 
     // 2. knob and label
     const int knobComponentSize = 200;     
@@ -82,15 +108,76 @@ void AltDenoiserEditor::resized()
         20
     );
 
-    // 3.info
+    // 3. status and info
+    statusLabel.setBounds(area.getCentreX() - 100, 36, 200, 16);
     aboutButton.setBounds(getWidth() - 30, 10, 20, 20);
+    traceButton.setBounds(10, 10, 44, 20);
+    telemetryLabel.setBounds(area.getCentreX() - 160, area.getBottom() - 20, 320, 14);
 }
 
 void AltDenoiserEditor::timerCallback()
 {
-    float rawIn = audioProcessor.inputRmsLevel.load();
-    float rawOut = audioProcessor.outputRmsLevel.load();
-
-    inputMeter.update(rawIn);
-    outputMeter.update(rawOut);
+    auto& meters = audioProcessor.getMeters();
+    const int numChannels = meters.getNumChannels();
+    std::array<LevelMeter::Levels, LevelMeter::maxChannels> inLevels, outLevels;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        inLevels[(size_t)ch] = meters.readInput(ch);
+        outLevels[(size_t)ch] = meters.readOutput(ch);
+    }
+
+    inputMeter.update(inLevels.data(), numChannels);
+    outputMeter.update(outLevels.data(), numChannels);
+    reductionMeter.update(meters.getGainReductionDb());
+
+    // usually one or two hops per tick, each a single new column
+    SpectrumMeter::Snapshot snapshot;
+    while (audioProcessor.getSpectrum().pop(snapshot))
+        spectrogram.push(snapshot);
+
+    juce::String status;
+    auto modelState = audioProcessor.getModelState();
+    if (modelState == ModelLoader::State::loading) status = "Loading model...";
+    else if (modelState == ModelLoader::State::failed) status = "Model failed to load";
+    else if (audioProcessor.getLoadedModelVariant() != audioProcessor.getRequestedModelVariant())
+        status = juce::String(ModelCache::variants[(size_t)audioProcessor.getRequestedModelVariant()].name) + " not installed";
+    else if (audioProcessor.isModelWaitingForRestart())
+        status = "Restart playback to switch the model's sample rate";
+
+    // a new trace, whether asked for or written after an overrun, is announced for a few seconds
+    auto trace = audioProcessor.getLastFlightTrace();
+    if (trace != shownTrace) {
+        shownTrace = trace;
+        traceTicks = 180;
+    }
+    if (traceTicks > 0) {
+        --traceTicks;
+        if (status.isEmpty()) status = "Trace saved to " + shownTrace.getParentDirectory().getFileName();
+    }
+    // so is a finished model load, with how long it took
+    auto loadTimeMs = audioProcessor.getModelLoadTimeMs();
+    if (loadTimeMs != shownLoadTimeMs) {
+        shownLoadTimeMs = loadTimeMs;
+        loadTicks = 180;
+    }
+    if (loadTicks > 0) {
+        --loadTicks;
+        if (status.isEmpty()) status = "Model loaded in " + juce::String(juce::roundToInt(shownLoadTimeMs)) + " ms";
+    }
+    if (statusLabel.getText() != status)
+        statusLabel.setText(status, juce::dontSendNotification);
+
+    // 4 Hz is plenty for numbers, and snapshot() sorts the hop history
+    if (++telemetryTicks >= 15) {
+        telemetryTicks = 0;
+        auto t = audioProcessor.getTelemetry();
+        auto text = juce::String::formatted("hop %.2f ms  p99 %.2f  max %.2f  underruns %d",
+                                            t.lastHopMs, t.p99HopMs, t.maxHopMs, (int)t.underruns);
+        // hops the load governor had to spend below full quality
+        auto degraded = t.tierHops[1] + t.tierHops[2] + t.tierHops[3];
+        if (degraded > 0)
+            text << "  degraded " << (juce::int64)degraded;
+        if (t.overflows > 0)
+            text << "  overflows " << (juce::int64)t.overflows;
+        telemetryLabel.setText(text, juce::dontSendNotification);
+    }
 }
\ No newline at end of file
@@ -49,17 +49,22 @@ class DbMeter : public juce::Component
 {
 public:
     DbMeter(bool isInputMode) : isInput(isInputMode) {}
-    void update(float newRawLevel) 
+    // one entry per channel: the bars follow the RMS, the number on top the peak
+    void update(const LevelMeter::Levels* levels, int numChannels) 
     {
-        const float attack = 1.0f;
         const float release = 0.8f;
-        
-        if (newRawLevel > smoothedLevel) smoothedLevel = newRawLevel; // Attack
-        else smoothedLevel *= release;                                // Release
-        
-        if (smoothedLevel < 1e-9f) smoothedLevel = 1e-9f;
+        numBars = juce::jlimit(1, LevelMeter::maxChannels, numChannels);
+
+        float peak = 0.0f;
+        for (int ch = 0; ch < numBars; ++ch) {
+            auto& smoothedLevel = smoothedLevels[(size_t)ch];
+            if (levels[ch].rms > smoothedLevel) smoothedLevel = levels[ch].rms; // Attack
+            else smoothedLevel *= release;                                      // Release
+            if (smoothedLevel < 1e-9f) smoothedLevel = 1e-9f;
+            peak = juce::jmax(peak, levels[ch].peak);
+        }
 
-        float currentDb = juce::Decibels::gainToDecibels(smoothedLevel, -100.0f);
+        float currentDb = juce::Decibels::gainToDecibels(peak, -100.0f);
         
         if (currentDb > displayedDb) {
             displayedDb = currentDb; 
@@ -67,7 +72,17 @@ public:
             displayedDb -= 0.5f;
         }
 
-        repaint();
+        // the ticks and labels cost more than the bars, skip the repaint when nothing moved,
+        // e.g. in silence or with the transport stopped
+        std::array<int, LevelMeter::maxChannels + 1> shown {};
+        for (int ch = 0; ch < numBars; ++ch)
+            shown[(size_t)ch] = juce::roundToInt(4.0f * juce::Decibels::gainToDecibels(smoothedLevels[(size_t)ch], -100.0f));
+        shown[LevelMeter::maxChannels] = displayedDb <= -90.0f ? -1000 : juce::roundToInt(10.0f * displayedDb);
+        if (shown != lastShown || numBars != lastNumBars) {
+            lastShown = shown;
+            lastNumBars = numBars;
+            repaint();
+        }
     }
 
     void paint(juce::Graphics& g) override
@@ -82,7 +97,10 @@ public:
                                .withTrimmedBottom(bottomTextHeight)
                                .reduced(internalPadding, 0);
 
-        const float barWidth = 12.0f;
+        // mono keeps the single 12 px bar, more channels get thinner ones side by side
+        const float gap = 2.0f;
+        const float channelWidth = numBars == 1 ? 12.0f : numBars == 2 ? 6.0f : 3.0f;
+        const float barWidth = (float)numBars * channelWidth + (float)(numBars - 1) * gap;
         juce::Rectangle<float> barRect;
         juce::Rectangle<float> tickArea;
 
@@ -94,11 +112,6 @@ public:
             tickArea = meterArea.withTrimmedRight(6.0f);
         }
 
-        g.setColour(juce::Colour(0xff181818));
-        g.fillRoundedRectangle(barRect, 2.0f);
-
-        float db = juce::Decibels::gainToDecibels(smoothedLevel, -100.0f);
-
         const float maxdB = 6.0f;
         const float mindB = -60.0f;
 
@@ -110,40 +123,47 @@ public:
         float yMinus6dB = mapDbToY(-6.0f);
         float yMinus24dB= mapDbToY(-24.0f);
         float yBottom   = barRect.getBottom();
-    
-        float yCurrent  = juce::jlimit(barRect.getY(), yBottom, mapDbToY(db));
 
-        g.saveState();
-        juce::Path clipPath;
-        clipPath.addRoundedRectangle(barRect, 2.0f);
-        g.reduceClipRegion(clipPath);
+        for (int ch = 0; ch < numBars; ++ch) {
+            auto channelRect = barRect.withX(barRect.getX() + (float)ch * (channelWidth + gap)).withWidth(channelWidth);
+            g.setColour(juce::Colour(0xff181818));
+            g.fillRoundedRectangle(channelRect, 2.0f);
 
-        float greenTop = juce::jmax(yCurrent, yMinus24dB);
-        if (greenTop < yBottom) {
-            g.setColour(juce::Colours::green);
-            g.fillRect(barRect.withTop(greenTop).withBottom(yBottom));
-        }
-        float gradTop = juce::jmax(yCurrent, yMinus6dB);
-        if (gradTop < yMinus24dB) {
-            juce::ColourGradient gradient(
-                juce::Colours::yellow, 0, yMinus6dB,
-                juce::Colours::green,  0, yMinus24dB, 
-                false
-            );
-            g.setGradientFill(gradient);
-            g.fillRect(barRect.withTop(gradTop).withBottom(yMinus24dB));
-        }
-        float yellowTop = juce::jmax(yCurrent, y0dB);
-        if (yellowTop < yMinus6dB) {
-            g.setColour(juce::Colours::yellow);
-            g.fillRect(barRect.withTop(yellowTop).withBottom(yMinus6dB));
-        }
-        if (yCurrent < y0dB) {
-            g.setColour(juce::Colours::red);
-            g.fillRect(barRect.withTop(yCurrent).withBottom(y0dB));
-        }
+            float db = juce::Decibels::gainToDecibels(smoothedLevels[(size_t)ch], -100.0f);
+            float yCurrent  = juce::jlimit(barRect.getY(), yBottom, mapDbToY(db));
+
+            g.saveState();
+            juce::Path clipPath;
+            clipPath.addRoundedRectangle(channelRect, 2.0f);
+            g.reduceClipRegion(clipPath);
+
+            float greenTop = juce::jmax(yCurrent, yMinus24dB);
+            if (greenTop < yBottom) {
+                g.setColour(juce::Colours::green);
+                g.fillRect(channelRect.withTop(greenTop).withBottom(yBottom));
+            }
+            float gradTop = juce::jmax(yCurrent, yMinus6dB);
+            if (gradTop < yMinus24dB) {
+                juce::ColourGradient gradient(
+                    juce::Colours::yellow, 0, yMinus6dB,
+                    juce::Colours::green,  0, yMinus24dB, 
+                    false
+                );
+                g.setGradientFill(gradient);
+                g.fillRect(channelRect.withTop(gradTop).withBottom(yMinus24dB));
+            }
+            float yellowTop = juce::jmax(yCurrent, y0dB);
+            if (yellowTop < yMinus6dB) {
+                g.setColour(juce::Colours::yellow);
+                g.fillRect(channelRect.withTop(yellowTop).withBottom(yMinus6dB));
+            }
+            if (yCurrent < y0dB) {
+                g.setColour(juce::Colours::red);
+                g.fillRect(channelRect.withTop(yCurrent).withBottom(y0dB));
+            }
 
-        g.restoreState();
+            g.restoreState();
+        }
 
         float barCenterX = barRect.getCentreX();
         // top:dB
@@ -178,11 +198,159 @@ public:
     }
 
 private:
-    float smoothedLevel = 0.0f;
+    std::array<float, LevelMeter::maxChannels> smoothedLevels {};
+    int numBars = 1;
     float displayedDb = -100.0f;
+    // what the last repaint showed: quarter dB per bar, then the peak in tenths
+    std::array<int, LevelMeter::maxChannels + 1> lastShown {};
+    int lastNumBars = 0;
     bool isInput;
 };
 
+// how far the output sits below the latency-aligned input, drawn from the top down
+class GainReductionMeter : public juce::Component
+{
+public:
+    void update(float reductionDb)
+    {
+        // fast attack, slow release, so short dips stay readable
+        if (reductionDb > smoothedDb) smoothedDb = reductionDb;
+        else smoothedDb = juce::jmax(0.0f, smoothedDb - 0.3f);
+        const int shown = juce::roundToInt(10.0f * smoothedDb);
+        if (shown != lastShown) {
+            lastShown = shown;
+            repaint();
+        }
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat();
+        const float textHeight = 18.0f;
+        const float maxReductionDb = 24.0f;
+
+        auto barRect = bounds.withTrimmedTop(textHeight).withTrimmedBottom(textHeight)
+                             .withSizeKeepingCentre(6.0f, bounds.getHeight() - 2.0f * textHeight);
+        g.setColour(juce::Colour(0xff181818));
+        g.fillRoundedRectangle(barRect, 2.0f);
+
+        float depth = juce::jlimit(0.0f, 1.0f, smoothedDb / maxReductionDb);
+        if (depth > 0.0f) {
+            g.setColour(juce::Colour(0xffff9900));
+            g.fillRoundedRectangle(barRect.withHeight(barRect.getHeight() * depth), 2.0f);
+        }
+
+        g.setColour(juce::Colours::white);
+        g.setFont(12.0f);
+        g.drawFittedText(juce::String(smoothedDb, 1), bounds.removeFromTop(textHeight).toNearestInt(),
+                         juce::Justification::centred, 1);
+        g.setFont(10.0f);
+        g.setColour(juce::Colours::grey);
+        g.drawFittedText("GR", bounds.removeFromBottom(textHeight).toNearestInt(), juce::Justification::centred, 1);
+    }
+
+private:
+    float smoothedDb = 0.0f;
+    int lastShown = -1;
+};
+
+// the last few seconds of SpectrumMeter snapshots, one column per 10 ms hop, in three strips:
+// the aligned input, the output and the per-band reduction between them, low bands at the bottom.
+// Columns are drawn into a cached image at a sweeping write head, so a new hop touches and
+// repaints two columns of pixels; the image is never redrawn or scrolled as a whole.
+class SpectrogramView : public juce::Component
+{
+public:
+    SpectrogramView()
+    {
+        setOpaque(true);
+        const juce::Colour dark(0xff141414), accent(0xffff9900);
+        for (int i = 0; i < 256; ++i) {
+            // -100 dB .. -10 dB
+            float t = juce::jlimit(0.0f, 1.0f, (SpectrumMeter::toDecibels((juce::uint8)i) + 100.0f) / 90.0f);
+            levelColours[(size_t)i] = t < 0.7f ? dark.interpolatedWith(juce::Colours::grey, t / 0.7f)
+                                               : juce::Colours::grey.interpolatedWith(juce::Colours::white, (t - 0.7f) / 0.3f);
+            // 0 .. 30 dB of reduction, in the same half dB steps
+            reductionColours[(size_t)i] = dark.interpolatedWith(accent, juce::jmin(1.0f, (float)i / 60.0f));
+        }
+    }
+
+    // message thread, once per snapshot
+    void push(const SpectrumMeter::Snapshot& snapshot)
+    {
+        if (!image.isValid() || rowBands.empty()) return;
+        const int stripHeight = (int)rowBands.size();
+        {
+            juce::Image::BitmapData pixels(image, writeX, 0, 1, image.getHeight(), juce::Image::BitmapData::writeOnly);
+            for (int y = 0; y < stripHeight; ++y) {
+                const auto band = (size_t)rowBands[(size_t)y];
+                const int in = snapshot.input[band], out = snapshot.output[band];
+                // nothing to reduce below the noise floor of the display
+                const int reduction = SpectrumMeter::toDecibels((juce::uint8)in) > -100.0f ? juce::jlimit(0, 255, in - out) : 0;
+                pixels.setPixelColour(0, y, levelColours[(size_t)in]);
+                pixels.setPixelColour(0, y + stripHeight + stripGap, levelColours[(size_t)out]);
+                pixels.setPixelColour(0, y + 2 * (stripHeight + stripGap), reductionColours[(size_t)reduction]);
+            }
+        }
+        repaint(labelWidth + writeX, 0, 1, getHeight());
+        writeX = (writeX + 1) % image.getWidth();
+        // a dark column ahead of the write head shows where the newest hop is
+        clearColumn(writeX);
+        repaint(labelWidth + writeX, 0, 1, getHeight());
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        // the labels only need drawing when the repaint reaches them
+        if (g.getClipBounds().getX() < labelWidth) {
+            g.setColour(juce::Colour(0xff1e1e1e));
+            g.fillRect(0, 0, labelWidth, getHeight());
+            g.setFont(10.0f);
+            g.setColour(juce::Colours::grey);
+            const int stripHeight = (int)rowBands.size();
+            const char* labels[] = { "IN", "OUT", "GR" };
+            for (int i = 0; i < 3; ++i)
+                g.drawText(labels[i], 0, i * (stripHeight + stripGap), labelWidth - 4, stripHeight,
+                           juce::Justification::centredRight, false);
+        }
+        if (image.isValid())
+            g.drawImageAt(image, labelWidth, 0);
+    }
+
+    void resized() override
+    {
+        const int width = getWidth() - labelWidth;
+        const int stripHeight = (getHeight() - 2 * stripGap) / 3;
+        if (width <= 0 || stripHeight <= 0) {
+            image = {};
+            rowBands.clear();
+            return;
+        }
+        image = juce::Image(juce::Image::RGB, width, getHeight(), false);
+        image.clear(image.getBounds(), background);
+        rowBands.resize((size_t)stripHeight);
+        for (int y = 0; y < stripHeight; ++y)
+            rowBands[(size_t)y] = (stripHeight - 1 - y) * SpectrumMeter::numBands / stripHeight;
+        writeX = 0;
+    }
+
+private:
+    static constexpr int labelWidth = 28;
+    static constexpr int stripGap = 2;
+    const juce::Colour background { 0xff1e1e1e };
+
+    void clearColumn(int x)
+    {
+        image.clear({ x, 0, 1, image.getHeight() }, background);
+    }
+
+    juce::Image image;
+    std::vector<int> rowBands; // band shown in each row of a strip, top row first
+    int writeX = 0;
+    std::array<juce::Colour, 256> levelColours;
+    std::array<juce::Colour, 256> reductionColours;
+};
+
 class AltDenoiserEditor : public juce::AudioProcessorEditor, public juce::Timer
 {
 public:
@@ -201,10 +369,20 @@ private:
 
     juce::Slider attenSlider;
     juce::Label attenLabel;
+    juce::Label statusLabel;
+    juce::Label telemetryLabel;
+    int telemetryTicks = 0;
     juce::TextButton aboutButton { "i" };
+    juce::TextButton traceButton { "trace" };
+    juce::File shownTrace;
+    int traceTicks = 0; // how much longer "saved" stays up
+    double shownLoadTimeMs = 0.0;
+    int loadTicks = 0;
 
     DbMeter inputMeter { true };  // true = IN mode
     DbMeter outputMeter { false }; // false = OUT mode
+    GainReductionMeter reductionMeter;
+    SpectrogramView spectrogram;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attenAttachment;
 
@@ -8,10 +8,48 @@ AltDenoiserProcessor::AltDenoiserProcessor()
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       apvts(*this, nullptr, "Parameters", createParameterLayout())
 {
-    dfProcessor = std::make_unique<DeepFilterNetProcessor>(48000);
+    // looked up once, processBlock only reads the atomics
+    attenLimParam = apvts.getRawParameterValue("atten_lim");
+    asyncModeParam = apvts.getRawParameterValue("async_mode");
+    stereoLinkParam = apvts.getRawParameterValue("stereo_link");
+    vadGateParam = apvts.getRawParameterValue("vad_gate");
+    gateFloorParam = apvts.getRawParameterValue("gate_floor");
+    latencyModeParam = apvts.getRawParameterValue("latency_mode");
+    modelParam = apvts.getRawParameterValue("model");
+    mixParam = apvts.getRawParameterValue("mix");
+    bypassParam = apvts.getRawParameterValue("bypass");
+    bypassWarmParam = apvts.getRawParameterValue("bypass_warm");
+    loadGovernorParam = apvts.getRawParameterValue("load_governor");
+
+    for (int ch = 0; ch < maxChannels; ++ch) {
+        channels.push_back(std::make_unique<ChannelProcessor>());
+        channels.back()->setTelemetry(&telemetry, ch);
+        channels.back()->setFlightRecorder(&flightRecorder);
+    }
+
+    // load in the background, the host never waits for df_create
+    modelLoader = std::make_unique<ModelLoader>(channels, [this] { reportLatency(); });
+    modelLoader->request(getTotalNumOutputChannels());
+
+    juce::StringArray paramNames;
+    for (auto* param : getParameters())
+        if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*>(param)) {
+            tracedParams.push_back(apvts.getRawParameterValue(withId->paramID));
+            tracedValues.push_back(tracedParams.back()->load());
+            paramNames.add(withId->paramID);
+        }
+    flightRecorder.setParameterNames(paramNames);
+
+    auto dumpPath = juce::SystemStats::getEnvironmentVariable("ALT_DENOISER_TELEMETRY", {});
+    if (juce::File::isAbsolutePath(dumpPath))
+        startTelemetryDump(juce::File(dumpPath));
 }
 
 AltDenoiserProcessor::~AltDenoiserProcessor() {
+    telemetryDump.reset();
+    modelLoader.reset();
+    for (auto& channel : channels)
+        channel->release();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout AltDenoiserProcessor::createParameterLayout() 
@@ -26,111 +64,425 @@ juce::AudioProcessorValueTreeState::ParameterLayout AltDenoiserProcessor::create
         range, 
         100.0f 
     ));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "async_mode",
+        "Async Inference",
+        false
+    ));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "stereo_link",
+        "Stereo Link",
+        false
+    ));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "vad_gate",
+        "Silence Gate",
+        true
+    ));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        "gate_floor",
+        "Silence Gate Floor",
+        juce::NormalisableRange<float>(-100.0f, -20.0f, 0.1f),
+        -60.0f
+    ));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        "latency_mode",
+        "Latency Mode",
+        juce::StringArray { "Low", "Safe" },
+        1
+    ));
+    juce::StringArray modelNames;
+    for (const auto& variant : ModelCache::variants)
+        modelNames.add(variant.name);
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        "model",
+        "Model",
+        modelNames,
+        ModelCache::defaultVariant
+    ));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        "mix",
+        "Mix",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f),
+        100.0f
+    ));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "bypass",
+        "Bypass",
+        false
+    ));
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "bypass_warm",
+        "Keep Model Running in Bypass",
+        false
+    ));
+    // off by default: degrading is a trade the user opts into on a machine that can't keep up
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        "load_governor",
+        "Degrade Under Load",
+        false
+    ));
 
     return layout;
 }
 
+bool AltDenoiserProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const {
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+    if (mainOutput.isDisabled() || mainOutput.size() > maxChannels)
+        return false;
+    return layouts.getMainInputChannelSet() == mainOutput;
+}
+
 void AltDenoiserProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
-    inputFifo.setSize(48000);
-    outputFifo.setSize(48000);
-    tempInputFrame.resize(480, 0.0f);
-    tempOutputFrame.resize(480, 0.0f);
+    hostSampleRate = sampleRate;
+    asyncActive = false;
+    linkActive = false;
 
-    int latencyInHost = juce::roundToInt(1920.0 * (sampleRate / 48000.0));
-    setLatencySamples(latencyInHost);
+    // one model state per channel, loaded in the background; until then dry audio passes through
+    numActiveChannels = juce::jlimit(1, maxChannels, getTotalNumOutputChannels());
+    modelLoader->requestVariant(getRequestedModelVariant());
+    modelLoader->request(numActiveChannels);
 
-    if (dfProcessor->initialize()) {
-        modelLoaded = true;
-    } else {
-        modelLoaded = false;
+    for (int ch = 0; ch < maxChannels; ++ch) {
+        if (ch < numActiveChannels) channels[ch]->prepare(sampleRate, samplesPerBlock);
+        else channels[ch]->release();
     }
+    // sized for the longest lookahead, so a model swap never allocates, and for every hop
+    // side can fall behind mid; in mono channel 1 was just released, it doesn't count
+    int maxBacklogHops = channels[0]->getMaxBacklogHops();
+    if (numActiveChannels >= 2)
+        maxBacklogHops = juce::jmax(maxBacklogHops, channels[1]->getMaxBacklogHops());
+    stereoLink.prepare(channels[0]->getFrameLength(), (1 + ModelCache::getMaxLookaheadHops()) * channels[0]->getFrameLength(),
+                       maxBacklogHops);
+    stereoLink.setModelDelay(channels[0]->getModelDelay());
+    channelPool.prepare(numActiveChannels - 1);
+    telemetry.reset();
+    telemetry.setNumChannels(numActiveChannels);
+    meters.reset(numActiveChannels);
+    spectrum.prepare(sampleRate);
+
+    // channels that just came back from release() haven't seen the governor setting yet
+    for (int ch = 0; ch < numActiveChannels; ++ch) {
+        channels[ch]->setLoadGovernorEnabled(governorActive);
+        channels[ch]->reset(ChannelProcessor::Role::independent, nullptr, false);
+    }
+
+    // room for the longest latency we may report until the next prepare: any variant at this
+    // rate, any mode, offline priming included
+    dryDelay.prepare(numActiveChannels, channels[0]->getMaxLatency());
+    dryBuffer.setSize(numActiveChannels, samplesPerBlock);
+    mixGains.assign((size_t)samplesPerBlock, 0.0f);
+    mixGain.reset(sampleRate, 0.02);
+    mixGain.setCurrentAndTargetValue(mixParam->load() * 0.01f);
+    maxBlockSize = samplesPerBlock;
+    wetReady = false;
+    offlineWaited = false;
+    wetGain = 0.0f;
+    wetTarget = 1.0f;
+    bypassCold = false;
+    resetPending = false;
+    wetGainStep = 1.0f / (float)juce::roundToInt(0.05 * sampleRate); // 50 ms fade-in
 
-    // init resampler
-    resamplerHandler = std::make_unique<Resampler<1, 1>>(sampleRate, 48000.0);
-    double maxRatio = 48000.0 / sampleRate;
-    int maxResampledSize = (int)(samplesPerBlock * maxRatio) + 128; // +128 for safety margin
-    resampleInBuffer.resize(maxResampledSize);
-    resampleOutBuffer.resize(maxResampledSize);
+    offlineActive = false;
+    lowLatencyActive = false;
+    updateLatency();
+    updateProcessingMode(asyncModeParam->load() > 0.5f,
+                         stereoLinkParam->load() > 0.5f,
+                         isNonRealtime(),
+                         latencyModeParam->load() < 0.5f,
+                         loadGovernorParam->load() > 0.5f);
+    // the host rereads it when prepareToPlay returns
+    reportLatency();
+    flightRecorder.setContext(juce::String(sampleRate) + " Hz, " + juce::String(samplesPerBlock) + " samples, "
+                              + juce::String(numActiveChannels) + " channels, model "
+                              + ModelCache::variants[(size_t)juce::jmax(0, getLoadedModelVariant())].name
+                              + " at " + juce::String(channels[0]->getModelSampleRate()) + " Hz");
 }
 
 void AltDenoiserProcessor::releaseResources() {
+    for (auto& channel : channels)
+        channel->release();
+    channelPool.release();
+    asyncActive = false;
+    linkActive = false;
+}
+
+int AltDenoiserProcessor::getRequestedModelVariant() const {
+    return juce::jlimit(0, ModelCache::numVariants - 1, juce::roundToInt(modelParam->load()));
+}
+
+void AltDenoiserProcessor::startTelemetryDump(const juce::File& file, int intervalMs) {
+    telemetryDump.reset();
+    telemetryDump = std::make_unique<TelemetryDump>(telemetry, file, intervalMs);
+}
+
+juce::uint32 AltDenoiserProcessor::getLateFrameCount() const {
+    juce::uint32 total = 0;
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+        total += channels[ch]->getWorker().getLateFrameCount();
+    return total;
+}
+
+juce::uint64 AltDenoiserProcessor::getInferredFrameCount() const {
+    juce::uint64 total = 0;
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+        total += channels[ch]->getInferredFrameCount();
+    return total;
+}
+
+juce::uint64 AltDenoiserProcessor::getSkippedFrameCount() const {
+    juce::uint64 total = 0;
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+        total += channels[ch]->getSkippedFrameCount();
+    return total;
+}
+
+juce::uint64 AltDenoiserProcessor::getTierHopCount(LoadGovernor::Counter counter) const {
+    juce::uint64 total = 0;
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+        total += channels[ch]->getTierHopCount(counter);
+    return total;
+}
+
+void AltDenoiserProcessor::reportLatency() {
+    // prepareToPlay and the loader may both report; whoever takes the value last sets it last
+    const juce::ScopedLock lock(reportLock);
+    const int latency = pendingLatency.exchange(-1);
+    if (latency >= 0)
+        setLatencySamples(latency);
 }
 
-void AltDenoiserProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+void AltDenoiserProcessor::updateLatency() {
+    int latency = channels[0]->getLatency();
+    dryDelay.setDelay(latency);
+    // setLatencySamples() notifies the host under a lock: leave that to the loader thread
+    currentLatency = latency;
+    pendingLatency.store(latency);
+    modelLoader->wake();
+
+    // the FIFOs were just reset: let the wet path fill up before fading it in again.
+    // a bounce has no dry phase to hide, it starts wet
+    warmupRemaining = offlineActive ? 0 : latency;
+    wetGain = offlineActive ? 1.0f : 0.0f;
+}
+
+void AltDenoiserProcessor::updateProcessingMode(bool wantAsync, bool wantLinked, bool wantOffline, bool wantLowLatency,
+                                                bool wantGovernor) {
+    wantLinked = wantLinked && numActiveChannels == 2;
+    // offline always pipelines through the workers
+    wantAsync = wantAsync || wantOffline;
+    // a model the loader has finished swaps in the same way, while every worker is parked
+    bool swapModel = false;
+    if (modelLoader->getState() == ModelLoader::State::ready)
+        for (int ch = 0; ch < numActiveChannels; ++ch)
+            swapModel = swapModel || channels[ch]->hasPendingModel();
+    if (wantAsync == asyncActive && wantLinked == linkActive && wantOffline == offlineActive
+        && wantLowLatency == lowLatencyActive && wantGovernor == governorActive && !swapModel && !resetPending) return;
+
+    // keep running the current mode until every worker has finished its current frame
+    bool allParked = true;
+    for (int ch = 0; ch < numActiveChannels; ++ch) {
+        channels[ch]->getWorker().requestDeactivate();
+        allParked = allParked && channels[ch]->getWorker().isParked();
+    }
+    if (!allParked) return;
+
+    asyncActive = wantAsync;
+    linkActive = wantLinked;
+    offlineActive = wantOffline;
+    lowLatencyActive = wantLowLatency;
+    governorActive = wantGovernor;
+    resetPending = false;
+    if (swapModel) {
+        for (int ch = 0; ch < numActiveChannels; ++ch)
+            channels[ch]->adoptPendingModel();
+        stereoLink.setModelDelay(channels[0]->getModelDelay());
+    }
+    stereoLink.reset();
+    for (int ch = 0; ch < numActiveChannels; ++ch) {
+        auto role = ChannelProcessor::Role::independent;
+        if (linkActive)
+            role = ch == 0 ? ChannelProcessor::Role::linkedMid : ChannelProcessor::Role::linkedSide;
+        channels[ch]->setLatencyMode(lowLatencyActive ? ChannelProcessor::LatencyMode::low : ChannelProcessor::LatencyMode::safe);
+        channels[ch]->setLoadGovernorEnabled(governorActive);
+        channels[ch]->reset(role, linkActive ? &stereoLink : nullptr, asyncActive, offlineActive);
+    }
+    updateLatency();
+}
+
+void AltDenoiserProcessor::processChannelJob(void* context, int channel) {
+    auto& self = *static_cast<AltDenoiserProcessor*>(context);
+    auto& buffer = *self.currentBuffer;
+    self.channels[channel]->process(buffer.getWritePointer(channel), buffer.getNumSamples());
+}
+
+void AltDenoiserProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) {
     juce::ScopedNoDenormals noDenormals;
+    const auto blockStart = FlightRecorder::now();
+
+    for (size_t i = 0; i < tracedParams.size(); ++i) {
+        const float value = tracedParams[i]->load(std::memory_order_relaxed);
+        if (value == tracedValues[i]) continue;
+        tracedValues[i] = value;
+        flightRecorder.mark(FlightRecorder::Type::parameter, -1, (float)i, value);
+    }
+
+    // every buffer is sized for the block announced in prepareToPlay; hosts that send more
+    // get it processed in pieces instead of a reallocation
+    const int totalNumSamples = buffer.getNumSamples();
+    if (totalNumSamples <= maxBlockSize || maxBlockSize <= 0) {
+        processChunk(buffer);
+    } else {
+        for (int start = 0; start < totalNumSamples; start += maxBlockSize) {
+            juce::AudioBuffer<float> chunk(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                           start, juce::jmin(maxBlockSize, totalNumSamples - start));
+            processChunk(chunk);
+        }
+    }
+
+    // a bounce has no deadline to miss
+    const auto blockEnd = FlightRecorder::now();
+    const float deadlineMs = (float)(1000.0 * totalNumSamples / hostSampleRate);
+    flightRecorder.span(FlightRecorder::Type::block, blockStart, blockEnd, -1, (float)totalNumSamples, deadlineMs);
+    const float blockMs = (float)(juce::Time::highResolutionTicksToSeconds(blockEnd - blockStart) * 1000.0);
+    if (blockMs > deadlineMs && !offlineActive) {
+        flightRecorder.trigger(FlightRecorder::Type::overrun, blockMs, deadlineMs);
+        // a real miss, what the load governor steps down on
+        for (int ch = 0; ch < numActiveChannels; ++ch)
+            channels[ch]->noteOverrun();
+    }
+}
+
+void AltDenoiserProcessor::processChunk(juce::AudioBuffer<float>& buffer) {
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     // safety check
-    if (!modelLoaded || dfProcessor == nullptr || !dfProcessor->isReady()) {
+    if (numActiveChannels == 0) {
         buffer.clear(); 
         return; 
     }
  
-    // input rms
-    const float smoothAlpha = 0.5f; // smoothing factor for RMS
-    float currentInRMS = 0.0f;
-    if (totalNumInputChannels > 0)
-        currentInRMS = buffer.getRMSLevel(0, 0, buffer.getNumSamples());
-    float oldIn = inputRmsLevel.load();
-    inputRmsLevel.store(oldIn * (1.0f - smoothAlpha) + currentInRMS * smoothAlpha);
-
     // clear and parameter update
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
-    float newAttenLim = *apvts.getRawParameterValue("atten_lim");
-    if (std::abs(newAttenLim - lastAttenLim) > 0.01f) {
-        dfProcessor->setAttenLim(newAttenLim);
-        lastAttenLim = newAttenLim;
+    // channels that sat out a bypass hold stale FIFOs and model state: reset them like a
+    // mode switch, which also brings back the warm-up and fade-in
+    const bool bypassed = bypassParam->load() > 0.5f;
+    if (!bypassed && bypassCold) {
+        bypassCold = false;
+        resetPending = true;
+    }
+    // a bounce can afford to wait for the model instead of rendering dry audio; the render
+    // thread has no deadline, so it waits once, on the first block, and never blocks the host
+    // in prepareToPlay; the model swaps in just below
+    if (!wetReady && !offlineWaited && isNonRealtime()) {
+        offlineWaited = true;
+        modelLoader->waitUntilLoaded(offlineLoadTimeoutMs);
     }
+    updateProcessingMode(asyncModeParam->load() > 0.5f,
+                         stereoLinkParam->load() > 0.5f,
+                         isNonRealtime(),
+                         latencyModeParam->load() < 0.5f,
+                         loadGovernorParam->load() > 0.5f);
+    modelLoader->requestVariant(getRequestedModelVariant());
+    // the channels ramp towards it hop by hop, however fast it is automated
+    float attenLim = attenLimParam->load();
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+        channels[ch]->setAttenLim(attenLim);
+    bool gateOn = vadGateParam->load() > 0.5f;
+    float gateFloor = gateFloorParam->load();
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+        channels[ch]->setGate(gateOn, gateFloor);
 
-    // resample
-    float* sourceInputPtrs[] = { buffer.getWritePointer(0) }; float* sourceOutputPtrs[] = { buffer.getWritePointer(0) }; 
-    float* targetInputPtrs[] = { resampleInBuffer.data() };   float* targetOutputPtrs[] = { resampleOutBuffer.data() };
     int hostNumSamples = buffer.getNumSamples();
-    resamplerHandler->process(
-        sourceInputPtrs,
-        sourceOutputPtrs,
-        targetInputPtrs,
-        targetOutputPtrs,
-        hostNumSamples,
-        // lambda callback
-        [&](float* const* input_buffers, float* const* output_buffers, int sample_count_48k) {
-            
-            auto* readPtr = input_buffers[0];   // 48kHz input
-            auto* writePtr = output_buffers[0]; // 48kHz output
-            inputFifo.push(readPtr, sample_count_48k);
-
-            // predict
-            while (inputFifo.getAvailable() >= 480) {
-                inputFifo.peek(tempInputFrame.data(), 480);
-                inputFifo.discard(480);
-                dfProcessor->processFrame(tempInputFrame.data(), tempOutputFrame.data());
-                outputFifo.push(tempOutputFrame.data(), 480);
-            }
-            // outputfifo ---> writePtr
-            int samplesAvailable = outputFifo.getAvailable();
-            int samplesToRead = juce::jmin(samplesAvailable, sample_count_48k);
-            if (samplesToRead > 0) {
-                outputFifo.peek(writePtr, samplesToRead);
-                outputFifo.discard(samplesToRead);
-            }
-            if (samplesToRead < sample_count_48k) {
-                juce::FloatVectorOperations::clear(writePtr + samplesToRead, sample_count_48k - samplesToRead);
-            }
+    int numChannels = juce::jmin(numActiveChannels, totalNumInputChannels, buffer.getNumChannels());
+
+    // latency-compensated dry signal, played until the model is ready; the input levels are
+    // taken on the way through
+    dryDelay.process(buffer, dryBuffer, numChannels, hostNumSamples, meters);
+
+    if (!wetReady) {
+        wetReady = true;
+        for (int ch = 0; ch < numActiveChannels; ++ch)
+            wetReady = wetReady && channels[ch]->isReady();
+        if (wetReady) {
+            warmupRemaining = offlineActive ? 0 : currentLatency;
+            wetGain = offlineActive ? 1.0f : 0.0f;
+        }
+    }
+
+    // bypass fades the wet path out; once it is gone nothing but the dry delay runs,
+    // unless the model is asked to keep running so leaving bypass needs no warm-up
+    wetTarget = bypassed ? 0.0f : 1.0f;
+    const bool skipWet = resetPending
+                      || (bypassed && wetGain <= 0.0f && bypassWarmParam->load() < 0.5f);
+    if (skipWet && bypassed)
+        bypassCold = true;
+
+    if (!wetReady || skipWet) {
+        for (int ch = 0; ch < numChannels; ++ch)
+            buffer.copyFrom(ch, 0, dryBuffer, ch, 0, hostNumSamples);
+    } else if (linkActive) {
+        // infer once on mid, side follows its gain
+        auto* left = buffer.getWritePointer(0);
+        auto* right = buffer.getWritePointer(1);
+        for (int i = 0; i < hostNumSamples; ++i) {
+            float mid = 0.5f * (left[i] + right[i]);
+            float side = 0.5f * (left[i] - right[i]);
+            left[i] = mid;
+            right[i] = side;
+        }
+        channels[0]->process(left, hostNumSamples);
+        channels[1]->process(right, hostNumSamples);
+        for (int i = 0; i < hostNumSamples; ++i) {
+            float mid = left[i];
+            float side = right[i];
+            left[i] = mid + side;
+            right[i] = mid - side;
         }
-    );
+    } else if (asyncActive && !offlineActive) {
+        // the workers already run in parallel, the audio thread only moves samples
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch]->process(buffer.getWritePointer(ch), hostNumSamples);
+    } else {
+        // sync: one model per thread. offline: each channel resamples on its own thread
+        // while its worker infers the hops ahead, so the stages overlap
+        currentBuffer = &buffer;
+        channelPool.run(&AltDenoiserProcessor::processChannelJob, this, numChannels);
+        currentBuffer = nullptr;
+    }
 
-    if (totalNumOutputChannels > 1) {
-        buffer.copyFrom(1, 0, buffer, 0, 0, hostNumSamples);
+    // output levels, and the reduction against the aligned dry signal, from the mix's own pass
+    if (wetReady)
+        mixInWet(buffer, numChannels);
+    else
+        meters.pushOutput(buffer, dryBuffer, numChannels, hostNumSamples);
+    // and per band, for the spectrogram, while an editor is open
+    spectrum.push(buffer, dryBuffer, numChannels, hostNumSamples);
+}
+
+void AltDenoiserProcessor::mixInWet(juce::AudioBuffer<float>& buffer, int numChannels) {
+    // dryBuffer is delayed by the reported latency, so dry and wet line up sample for sample
+    const int numSamples = buffer.getNumSamples();
+    mixGain.setTargetValue(mixParam->load() * 0.01f);
+
+    if (warmupRemaining == 0 && wetGain == wetTarget && !mixGain.isSmoothing()) {
+        const float gain = wetGain * mixGain.getTargetValue();
+        if (gain >= 1.0f) meters.pushOutput(buffer, dryBuffer, numChannels, numSamples);
+        else meters.mixOutput(buffer, dryBuffer, numChannels, nullptr, gain, numSamples);
+        return;
     }
 
-    // output RMS
-    float currentOutRMS = 0.0f;
-    if (totalNumOutputChannels > 0)
-        currentOutRMS = buffer.getRMSLevel(0, 0, buffer.getNumSamples());        
-    float oldOut = outputRmsLevel.load();
-    outputRmsLevel.store(oldOut * (1.0f - smoothAlpha) + currentOutRMS * smoothAlpha);
+    // fade and mix ramp as one gain curve, shared by every channel
+    auto* gains = mixGains.data();
+    for (int i = 0; i < numSamples; ++i) {
+        if (warmupRemaining > 0) --warmupRemaining;
+        else if (wetGain < wetTarget) wetGain = juce::jmin(wetTarget, wetGain + wetGainStep);
+        else wetGain = juce::jmax(wetTarget, wetGain - wetGainStep);
+        gains[i] = wetGain * mixGain.getNextValue();
+    }
+    meters.mixOutput(buffer, dryBuffer, numChannels, gains, 0.0f, numSamples);
 }
 
 juce::AudioProcessorEditor* AltDenoiserProcessor::createEditor() {return new AltDenoiserEditor(*this, apvts);}
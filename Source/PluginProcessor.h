@@ -1,49 +1,18 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include "DeepFilterNetProcessor.h"
-#include "Resampler.hpp"
+#include "ChannelProcessor.h"
+#include "ChannelThreadPool.h"
+#include "StereoLink.h"
+#include "DryDelay.h"
+#include "ModelLoader.h"
+#include "Telemetry.h"
+#include "FlightRecorder.h"
+#include "LevelMeter.h"
+#include "SpectrumMeter.h"
 #include <vector>
 #include <memory>
 
-class SimpleFifo {
-public:
-    void setSize(int size) { 
-        buffer.resize(size, 0.0f); 
-        writePos = 0; readPos = 0; samplesInFifo = 0; 
-    }
-    
-    void push(const float* data, int numSamples) {
-        for (int i = 0; i < numSamples; ++i) {
-            buffer[writePos] = data[i];
-            writePos = (writePos + 1) % buffer.size();
-        }
-        samplesInFifo += numSamples;
-        if (samplesInFifo > buffer.size()) samplesInFifo = buffer.size();
-    }
-    
-    void peek(float* dest, int numSamples) {
-        int tempRead = readPos;
-        for (int i = 0; i < numSamples; ++i) {
-            dest[i] = buffer[tempRead];
-            tempRead = (tempRead + 1) % buffer.size();
-        }
-    }
-    
-    void discard(int numSamples) {
-        readPos = (readPos + numSamples) % buffer.size();
-        samplesInFifo -= numSamples;
-    }
-    
-    int getAvailable() const { return samplesInFifo; }
-
-private:
-    std::vector<float> buffer;
-    int writePos = 0;
-    int readPos = 0;
-    int samplesInFifo = 0;
-};
-
 class AltDenoiserProcessor : public juce::AudioProcessor {
 public:
     AltDenoiserProcessor();
@@ -52,6 +21,7 @@ public:
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -60,6 +30,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     double getTailLengthSeconds() const override { return 0.0; }
+    juce::AudioProcessorParameter* getBypassParameter() const override { return apvts.getParameter("bypass"); }
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -67,14 +38,14 @@ public:
     const juce::String getProgramName(int) override { return "Default"; }
     void changeProgramName(int, const juce::String&) override {}
 
-    void AltDenoiserProcessor::getStateInformation(juce::MemoryBlock& destData)
+    void getStateInformation(juce::MemoryBlock& destData)
     {
         auto state = apvts.copyState();
         std::unique_ptr<juce::XmlElement> xml(state.createXml());
         copyXmlToBinary(*xml, destData);
     }
 
-    void AltDenoiserProcessor::setStateInformation(const void* data, int sizeInBytes)
+    void setStateInformation(const void* data, int sizeInBytes)
     {
         std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
@@ -87,23 +58,112 @@ public:
         }
     }
 
-    std::atomic<float> inputRmsLevel { 0.0f };
-    std::atomic<float> outputRmsLevel { 0.0f };
+    juce::uint32 getLateFrameCount() const;
+    // silence gate: hops that ran the model, and hops it skipped
+    juce::uint64 getInferredFrameCount() const;
+    juce::uint64 getSkippedFrameCount() const;
+    // hops each channel spent per load governor tier, summed
+    juce::uint64 getTierHopCount(LoadGovernor::Counter counter) const;
+
+    // polled by the editor
+    ModelLoader::State getModelState() const { return modelLoader->getState(); }
+    double getModelLoadTimeMs() const { return modelLoader->getLoadTimeMs(); }
+    // the "model" parameter, and what is actually loaded (the default if that one isn't installed)
+    int getRequestedModelVariant() const;
+    int getLoadedModelVariant() const { return modelLoader->getLoadedVariant(); }
+    // the loaded model runs at another rate than the current one, it takes over on the next prepareToPlay
+    bool isModelWaitingForRestart() const { return channels[0]->needsPrepareForModel(); }
+
+    // inference timing, FIFO depths and underruns; any thread, also without an editor
+    Telemetry::Snapshot getTelemetry() const { return telemetry.snapshot(); }
+    // one JSON line per interval appended to file; also started by ALT_DENOISER_TELEMETRY=<path>
+    void startTelemetryDump(const juce::File& file, int intervalMs = 1000);
+    void stopTelemetryDump() { telemetryDump.reset(); }
+
+    // per-channel input/output levels and gain reduction, read by the editor
+    LevelMeter& getMeters() { return meters; }
+    // per-hop band levels of the aligned input and the output, for the editor's spectrogram
+    SpectrumMeter& getSpectrum() { return spectrum; }
+
+    // the last few seconds of block, resampler and inference timings, written as a trace file
+    // on every overrun; any thread can ask for one too
+    void requestFlightTrace() { flightRecorder.trigger(FlightRecorder::Type::request); }
+    juce::File getLastFlightTrace() const { return flightRecorder.getLastTrace(); }
+
     juce::AudioProcessorValueTreeState apvts;
 
 private:
-    std::unique_ptr<DeepFilterNetProcessor> dfProcessor;
-
-    SimpleFifo inputFifo;
-    SimpleFifo outputFifo;
-    std::vector<float> tempInputFrame;
-    std::vector<float> tempOutputFrame;
-    bool modelLoaded = false;
-    float lastAttenLim = -1.0f;
-
-    std::unique_ptr<Resampler<1, 1>> resamplerHandler;
-    std::vector<float> resampleInBuffer;
-    std::vector<float> resampleOutBuffer;
+    // processBlock, at most maxBlockSize samples at a time
+    void processChunk(juce::AudioBuffer<float>& buffer);
+    // audio thread: switches the dry delay at once, the host hears of it from reportLatency()
+    void updateLatency();
+    // message or loader thread: hands the latency updateLatency() left to the host
+    void reportLatency();
+    void updateProcessingMode(bool wantAsync, bool wantLinked, bool wantOffline, bool wantLowLatency, bool wantGovernor);
+    static void processChannelJob(void* context, int channel);
+    // fades and mixes the dry signal back in, metering the output in the same pass
+    void mixInWet(juce::AudioBuffer<float>& buffer, int numChannels);
+
+    static constexpr int maxChannels = 8; // up to 7.1
+
+    // outlives the channels that write into it
+    Telemetry telemetry;
+    std::unique_ptr<TelemetryDump> telemetryDump;
+    FlightRecorder flightRecorder;
+    LevelMeter meters;
+    SpectrumMeter spectrum;
+    // every parameter, compared once per block so changes show up in the flight recorder
+    std::vector<std::atomic<float>*> tracedParams;
+    std::vector<float> tracedValues;
+
+    // always maxChannels long so the loader can walk it; only the first numActiveChannels run
+    std::vector<std::unique_ptr<ChannelProcessor>> channels;
+    std::unique_ptr<ModelLoader> modelLoader;
+    int numActiveChannels = 0;
+    ChannelThreadPool channelPool;
+    StereoLink stereoLink;
+    juce::AudioBuffer<float>* currentBuffer = nullptr;
+
+    // until the model is ready the delayed dry signal plays, then the wet one fades in
+    DryDelay dryDelay;
+    juce::AudioBuffer<float> dryBuffer;
+    bool wetReady = false;
+    bool offlineWaited = false; // the render thread waits for the model at most once per prepare
+    int currentLatency = 0;
+    std::atomic<int> pendingLatency { -1 }; // not yet reported to the host
+    juce::CriticalSection reportLock;
+    static constexpr int offlineLoadTimeoutMs = 10000;
+    int warmupRemaining = 0;
+    float wetGain = 0.0f;
+    float wetGainStep = 0.0f;
+    float wetTarget = 1.0f; // 0 while bypassed
+    // bypass: channels skipped while faded out are reset when it is left
+    bool bypassCold = false;
+    bool resetPending = false;
+    // dry/wet, on top of the fade-in
+    juce::SmoothedValue<float> mixGain;
+    std::vector<float> mixGains;
+
+    int maxBlockSize = 0;
+
+    std::atomic<float>* attenLimParam = nullptr;
+    std::atomic<float>* asyncModeParam = nullptr;
+    std::atomic<float>* stereoLinkParam = nullptr;
+    std::atomic<float>* vadGateParam = nullptr;
+    std::atomic<float>* gateFloorParam = nullptr;
+    std::atomic<float>* latencyModeParam = nullptr;
+    std::atomic<float>* modelParam = nullptr;
+    std::atomic<float>* mixParam = nullptr;
+    std::atomic<float>* bypassParam = nullptr;
+    std::atomic<float>* bypassWarmParam = nullptr;
+    std::atomic<float>* loadGovernorParam = nullptr;
+
+    bool asyncActive = false;
+    bool linkActive = false;
+    bool offlineActive = false; // host is bouncing: pipelined, blocking, no deadline
+    bool lowLatencyActive = false; // async worker primed to the minimum instead of with slack
+    bool governorActive = false;
+    double hostSampleRate = 48000.0;
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AltDenoiserProcessor)
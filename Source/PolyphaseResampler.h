@@ -0,0 +1,234 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define ALT_DENOISER_POLYPHASE_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define ALT_DENOISER_POLYPHASE_NEON 1
+#endif
+
+// Rational host <-> model rate converter, e.g. 44.1 kHz <-> 48 kHz as 160/147.
+// prepare() builds one Kaiser windowed sinc per direction, split into a table of polyphase
+// branches, so every output sample is a single vectorised dot product against contiguous
+// history. Linear phase: the round trip delay is known exactly and reported, nothing is measured.
+// Streaming state is a fixed history per direction; process calls never allocate.
+//
+// toModelRate() is driven by its input, fromModelRate() by its output, so a host block of n
+// samples always comes back as exactly n samples without any extra buffering delay.
+class PolyphaseResampler {
+public:
+    static constexpr int baseTaps = 64;          // per branch, at the lower of the two rates
+    static constexpr int maxTableSize = 1 << 16; // coefficients per direction
+    static constexpr double kaiserBeta = 8.0;    // ~80 dB stopband
+    static constexpr double cutoff = 0.45;       // of the lower rate
+    static constexpr int maxPending = 16;
+
+    // true if both rates are whole and their ratio small enough for a table
+    static bool supports(double hostRate, double modelRate) {
+        Ratio r;
+        return getRatio(hostRate, modelRate, r)
+            && r.up < maxPending * r.down // what fromModelRate() may have to hold over
+            && (juce::int64)r.up * getTaps(hostRate, modelRate) <= maxTableSize
+            && (juce::int64)r.down * getTaps(modelRate, hostRate) <= maxTableSize;
+    }
+
+    // not real-time safe
+    bool prepare(double newHostRate, double newModelRate) {
+        Ratio r;
+        if (!supports(newHostRate, newModelRate) || !getRatio(newHostRate, newModelRate, r)) return false;
+        hostRate = newHostRate;
+        modelRate = newModelRate;
+        const double lowerRate = juce::jmin(hostRate, modelRate);
+        toModel.prepare(r.up, r.down, getTaps(hostRate, modelRate), hostRate, lowerRate);
+        fromModel.prepare(r.down, r.up, getTaps(modelRate, hostRate), modelRate, lowerRate);
+        reset();
+        return true;
+    }
+
+    void reset() {
+        toModel.reset(0);
+        // the first output pulls the first model sample, which toModelRate() emitted at phase 0
+        fromModel.reset(fromModel.up);
+    }
+
+    // round trip delay of both filters, in host samples; usually fractional
+    double getLatency() const {
+        // both prototypes run at the same rate, hostRate * up = modelRate * down
+        return (toModel.getCentre() + fromModel.getCentre()) / (double)toModel.up;
+    }
+
+    // most model-rate samples numSamples host samples can turn into
+    int getMaxModelSamples(int numSamples) const {
+        return (int)(((juce::int64)numSamples * toModel.up + toModel.down - 1) / toModel.down) + 1;
+    }
+
+    // host rate -> model rate, returns the number of samples written
+    int toModelRate(const float* input, float* output, int numSamples) {
+        auto& s = toModel;
+        int numOut = 0;
+        for (int i = 0; i < numSamples; ++i) {
+            s.push(input[i]);
+            // every output whose time falls before the next input sample
+            for (; s.phase < s.up; s.phase += s.down)
+                output[numOut++] = s.branch(s.phase);
+            s.phase -= s.up;
+        }
+        return numOut;
+    }
+
+    // model rate -> host rate; consumes the numInput samples from the matching toModelRate() call,
+    // leaving at most a few for the next block
+    void fromModelRate(const float* input, int numInput, float* output, int numSamples) {
+        auto& s = fromModel;
+        int next = 0;
+        for (int i = 0; i < numSamples; ++i) {
+            // pull model samples until this output's time is covered
+            for (; s.phase >= s.up; s.phase -= s.up) {
+                if (s.numPending > 0) {
+                    s.push(s.pending[0]);
+                    std::copy(s.pending.begin() + 1, s.pending.begin() + s.numPending, s.pending.begin());
+                    --s.numPending;
+                } else {
+                    s.push(next < numInput ? input[next++] : 0.0f);
+                }
+            }
+            output[i] = s.branch(s.phase);
+            s.phase += s.down;
+        }
+        // produced this block but not due yet: at most one host sample's worth
+        while (next < numInput && s.numPending < (int)s.pending.size())
+            s.pending[(size_t)s.numPending++] = input[next++];
+        jassert(next == numInput);
+    }
+
+private:
+    struct Ratio { int up = 1, down = 1; };
+
+    static bool getRatio(double from, double to, Ratio& r) {
+        if (from <= 0.0 || to <= 0.0 || from != std::floor(from) || to != std::floor(to)) return false;
+        auto a = (juce::int64)from, b = (juce::int64)to;
+        auto g = std::gcd(a, b);
+        r.up = (int)(b / g);
+        r.down = (int)(a / g);
+        return true;
+    }
+
+    // taps per branch, in input samples: a lower output rate needs a proportionally longer filter
+    static int getTaps(double inputRate, double outputRate) {
+        int taps = (int)std::ceil(baseTaps * juce::jmax(1.0, inputRate / outputRate));
+        return (taps + 3) & ~3;
+    }
+
+    static double besselI0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50 && term > 1.0e-12 * sum; ++k) {
+            term *= (x * x) / (4.0 * k * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    struct Stage {
+        int up = 1, down = 1;
+        int taps = 0;
+        std::vector<float> table;   // up branches of taps coefficients, oldest input first
+        std::vector<float> history; // doubled, so the newest taps samples are always contiguous
+        std::array<float, maxPending> pending {};
+        int numPending = 0;
+        int pos = 0;
+        int phase = 0;
+
+        void prepare(int newUp, int newDown, int newTaps, double inputRate, double lowerRate) {
+            up = newUp;
+            down = newDown;
+            taps = newTaps;
+            const int length = up * taps;
+            const double centre = getCentre();
+            const double fc = cutoff * lowerRate / (inputRate * up); // of the prototype's rate
+            std::vector<double> h((size_t)length);
+            double sum = 0.0;
+            for (int i = 0; i < length; ++i) {
+                double t = i - centre;
+                double x = juce::MathConstants<double>::twoPi * fc * t;
+                double sinc = t == 0.0 ? 2.0 * fc : std::sin(x) / (juce::MathConstants<double>::pi * t);
+                double r = 2.0 * t / (length - 1);
+                double window = besselI0(kaiserBeta * std::sqrt(juce::jmax(0.0, 1.0 - r * r))) / besselI0(kaiserBeta);
+                h[(size_t)i] = sinc * window;
+                sum += h[(size_t)i];
+            }
+            // each branch passes DC at unity
+            table.assign((size_t)length, 0.0f);
+            for (int p = 0; p < up; ++p)
+                for (int k = 0; k < taps; ++k)
+                    table[(size_t)(p * taps + taps - 1 - k)] = (float)(h[(size_t)(p + up * k)] * up / sum);
+            history.assign((size_t)(2 * taps), 0.0f);
+        }
+
+        void reset(int initialPhase) {
+            std::fill(history.begin(), history.end(), 0.0f);
+            pos = 0;
+            phase = initialPhase;
+            numPending = 0;
+        }
+
+        // centre of the prototype filter, in prototype samples
+        double getCentre() const { return 0.5 * (up * taps - 1); }
+
+        void push(float x) {
+            history[(size_t)pos] = x;
+            history[(size_t)(pos + taps)] = x;
+            if (++pos == taps) pos = 0;
+        }
+
+        float branch(int p) const {
+            return dot(table.data() + (size_t)p * (size_t)taps, history.data() + pos, taps);
+        }
+    };
+
+    // taps is a multiple of 4
+    static float dot(const float* a, const float* b, int n) {
+#if ALT_DENOISER_POLYPHASE_SSE
+        __m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        if (i < n)
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(sum0, sum1));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif ALT_DENOISER_POLYPHASE_NEON
+        float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = vdupq_n_f32(0.0f);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+            sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        if (i < n)
+            sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        float lanes[4];
+        vst1q_f32(lanes, vaddq_f32(sum0, sum1));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i)
+            sum += a[i] * b[i];
+        return sum;
+#endif
+    }
+
+    double hostRate = 48000.0;
+    double modelRate = 48000.0;
+    Stage toModel;
+    Stage fromModel;
+};
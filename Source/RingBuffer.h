@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Single-threaded float ring buffer with a power-of-two capacity.
+// Positions are free-running counters masked on access, copies are at most two memcpys.
+// The first maxSpan samples are mirrored past the end, so readSpan() and writeSpan()
+// can hand out up to maxSpan contiguous samples of ring memory without copying.
+// Overflow and underflow are never clamped silently: the call fails and is counted.
+class RingBuffer {
+public:
+    // not real-time safe; capacity is rounded up to a power of two
+    void setSize(int minCapacity, int maxSpan) {
+        uint32_t size = 1;
+        while (size < (uint32_t)std::max(minCapacity, 1)) size <<= 1;
+        capacity = size;
+        mask = size - 1;
+        guard = (uint32_t)std::min(std::max(maxSpan, 0), (int)size);
+        buffer.assign(capacity + guard, 0.0f);
+        reset();
+    }
+
+    void reset() {
+        readIndex = 0;
+        writeIndex = 0;
+        overflows = 0;
+        underflows = 0;
+    }
+
+    int getCapacity() const { return (int)capacity; }
+    int getMaxSpan() const { return (int)guard; }
+    int getNumReady() const { return (int)(writeIndex - readIndex); }
+    int getFreeSpace() const { return (int)(capacity - (writeIndex - readIndex)); }
+    uint32_t getOverflowCount() const { return overflows; }
+    uint32_t getUnderflowCount() const { return underflows; }
+
+    // all or nothing: returns false and writes nothing if there is no room
+    bool write(const float* src, int numSamples) {
+        if (numSamples > getFreeSpace()) { ++overflows; return false; }
+        const uint32_t pos = writeIndex & mask;
+        const uint32_t first = std::min((uint32_t)numSamples, capacity - pos);
+        std::memcpy(buffer.data() + pos, src, first * sizeof(float));
+        std::memcpy(buffer.data(), src + first, (numSamples - first) * sizeof(float));
+        mirror(pos, (uint32_t)numSamples);
+        writeIndex += (uint32_t)numSamples;
+        return true;
+    }
+
+    // reads up to numSamples, zero-fills the rest and counts an underflow if short
+    int read(float* dest, int numSamples) {
+        const int numRead = std::min(numSamples, getNumReady());
+        if (numRead < numSamples) {
+            ++underflows;
+            std::fill(dest + numRead, dest + numSamples, 0.0f);
+        }
+        const uint32_t pos = readIndex & mask;
+        const uint32_t first = std::min((uint32_t)numRead, capacity - pos);
+        std::memcpy(dest, buffer.data() + pos, first * sizeof(float));
+        std::memcpy(dest + first, buffer.data(), (numRead - first) * sizeof(float));
+        readIndex += (uint32_t)numRead;
+        return numRead;
+    }
+
+    // zero-copy read: numSamples contiguous samples, or nullptr on underflow; follow with discard()
+    const float* readSpan(int numSamples) {
+        if (numSamples > (int)guard) return nullptr;
+        if (numSamples > getNumReady()) { ++underflows; return nullptr; }
+        return buffer.data() + (readIndex & mask);
+    }
+
+    void discard(int numSamples) {
+        readIndex += (uint32_t)std::min(numSamples, getNumReady());
+    }
+
+    // zero-copy write: room for numSamples contiguous samples, or nullptr on overflow; follow with commit()
+    float* writeSpan(int numSamples) {
+        if (numSamples > (int)guard) return nullptr;
+        if (numSamples > getFreeSpace()) { ++overflows; return nullptr; }
+        return buffer.data() + (writeIndex & mask);
+    }
+
+    void commit(int numSamples) {
+        const uint32_t pos = writeIndex & mask;
+        // the span may have run into the mirror, fold that part back to the start
+        if (pos + numSamples > capacity)
+            std::memcpy(buffer.data(), buffer.data() + capacity, (pos + numSamples - capacity) * sizeof(float));
+        mirror(pos, (uint32_t)numSamples);
+        writeIndex += (uint32_t)numSamples;
+    }
+
+private:
+    // copy whatever part of [pos, pos + n) landed in the first guard samples to the mirror
+    void mirror(uint32_t pos, uint32_t n) {
+        if (pos + n > capacity) {
+            mirrorRange(0, pos + n - capacity);
+            mirrorRange(pos, capacity);
+        } else {
+            mirrorRange(pos, pos + n);
+        }
+    }
+
+    void mirrorRange(uint32_t start, uint32_t end) {
+        end = std::min(end, guard);
+        if (start < end)
+            std::memcpy(buffer.data() + capacity + start, buffer.data() + start, (end - start) * sizeof(float));
+    }
+
+    std::vector<float> buffer;
+    uint32_t capacity = 0;
+    uint32_t mask = 0;
+    uint32_t guard = 0;
+    uint32_t readIndex = 0;
+    uint32_t writeIndex = 0;
+    uint32_t overflows = 0;
+    uint32_t underflows = 0;
+};
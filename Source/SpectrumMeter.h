@@ -0,0 +1,195 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <vector>
+
+// Band magnitudes of the latency-aligned input and the output, one snapshot per 10 ms hop,
+// for the editor's spectrogram and per-band gain reduction.
+// The audio thread only averages the channels and hands both sides over as raw samples,
+// through an SPSC ring; nothing is queued while no editor is open. The editor's timer drains
+// the ring in pop() and, once per hop, transforms the last fftSize samples of both sides
+// together as one complex juce::dsp::FFT: dry in the real part, output in the imaginary part.
+// Unlike a stream of finished snapshots, this moves two floats per sample instead of 96 bytes
+// per hop, but keeps every transform off the audio and inference threads.
+class SpectrumMeter {
+public:
+    static constexpr int numBands = 48;
+    static constexpr int ringSize = 1 << 15; // samples per side, 680 ms at 48 kHz; drained at 60 Hz
+    static constexpr int maxChannels = 8;
+    static constexpr float minFrequency = 40.0f;
+    static constexpr float maxFrequency = 20000.0f;
+
+    // 0.5 dB steps from -120 dB
+    struct Snapshot {
+        std::array<juce::uint8, numBands> input {};
+        std::array<juce::uint8, numBands> output {};
+    };
+
+    static float toDecibels(juce::uint8 level) { return -120.0f + 0.5f * (float)level; }
+
+    SpectrumMeter() {
+        dryRing.resize((size_t)ringSize);
+        outRing.resize((size_t)ringSize);
+    }
+
+    // any thread; the editor rebuilds its analysis for the new rate on its next pop()
+    void prepare(double newSampleRate) { sampleRate.store(newSampleRate); }
+
+    // editor: samples are only handed over while somebody looks at them
+    void setActive(bool shouldBeActive) {
+        // the editor is the reader: drop what is left from the last time it looked
+        if (shouldBeActive)
+            queue.finishedRead(queue.getNumReady());
+        active.store(shouldBeActive);
+    }
+
+    // audio thread, after processing; dry is the input delayed by the reported latency
+    void push(const juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& dry, int numChannels, int numSamples) {
+        const int n = juce::jmin(juce::jmin(numChannels, maxChannels), buffer.getNumChannels(), dry.getNumChannels());
+        if (!active.load(std::memory_order_relaxed) || n <= 0) return;
+
+        std::array<const float*, maxChannels> dryData, outData;
+        for (int ch = 0; ch < n; ++ch) {
+            dryData[(size_t)ch] = dry.getReadPointer(ch);
+            outData[(size_t)ch] = buffer.getReadPointer(ch);
+        }
+        // the editor stopped reading: keep what is queued, drop the rest
+        int start1, size1, start2, size2;
+        queue.prepareToWrite(numSamples, start1, size1, start2, size2);
+        const float scale = 1.0f / (float)n;
+        mixDown(dryData.data(), outData.data(), n, scale, 0, start1, size1);
+        mixDown(dryData.data(), outData.data(), n, scale, size1, start2, size2);
+        queue.finishedWrite(size1 + size2);
+    }
+
+    // editor; false once the ring holds less than a hop
+    bool pop(Snapshot& snapshot) {
+        const double rate = sampleRate.load();
+        if (rate != analysisRate) prepareAnalysis(rate);
+
+        const int mask = fftSize - 1;
+        while (samplesToHop > 0) {
+            int start1, size1, start2, size2;
+            queue.prepareToRead(samplesToHop, start1, size1, start2, size2);
+            if (size1 + size2 == 0) return false;
+            for (int i = 0; i < size1 + size2; ++i) {
+                const int pos = i < size1 ? start1 + i : start2 + i - size1;
+                dryHistory[(size_t)historyPos] = dryRing[(size_t)pos];
+                outHistory[(size_t)historyPos] = outRing[(size_t)pos];
+                historyPos = (historyPos + 1) & mask;
+            }
+            queue.finishedRead(size1 + size2);
+            samplesToHop -= size1 + size2;
+        }
+        samplesToHop = hopSize;
+        analyse(snapshot);
+        return true;
+    }
+
+private:
+    // block samples [from, from + count) into ring slots [start, start + count)
+    void mixDown(const float* const* dryData, const float* const* outData, int n, float scale, int from, int start, int count) {
+        for (int i = 0; i < count; ++i) {
+            float d = 0.0f, o = 0.0f;
+            for (int ch = 0; ch < n; ++ch) {
+                d += dryData[ch][from + i];
+                o += outData[ch][from + i];
+            }
+            dryRing[(size_t)(start + i)] = d * scale;
+            outRing[(size_t)(start + i)] = o * scale;
+        }
+    }
+
+    // editor
+    void prepareAnalysis(double rate) {
+        analysisRate = rate;
+        hopSize = juce::jmax(1, juce::roundToInt(rate / 100.0));
+        // about 47 Hz bins whatever the rate, so the low bands keep their resolution
+        fftOrder = juce::jlimit(8, 13, (int)std::ceil(std::log2(rate * 1024.0 / 48000.0)));
+        fftSize = 1 << fftOrder;
+
+        window.resize((size_t)fftSize);
+        double windowPower = 0.0;
+        for (int n = 0; n < fftSize; ++n) {
+            window[(size_t)n] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float)n / (float)fftSize);
+            windowPower += window[(size_t)n] * window[(size_t)n];
+        }
+        // band energy -> mean square of the band's signal; one side of the spectrum only
+        powerScale = (float)(2.0 / (fftSize * windowPower));
+
+        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+
+        // log spaced, every band at least one bin wide
+        const float top = juce::jmin(maxFrequency, 0.47f * (float)rate);
+        const float binWidth = (float)rate / (float)fftSize;
+        int lastBin = 1;
+        for (int b = 0; b <= numBands; ++b) {
+            float frequency = minFrequency * std::pow(top / minFrequency, (float)b / (float)numBands);
+            int bin = juce::jlimit(1, fftSize / 2, juce::roundToInt(frequency / binWidth));
+            bandEdges[(size_t)b] = b == 0 ? bin : juce::jmax(bin, lastBin + 1);
+            lastBin = bandEdges[(size_t)b];
+        }
+
+        dryHistory.assign((size_t)fftSize, 0.0f);
+        outHistory.assign((size_t)fftSize, 0.0f);
+        fftInput.resize((size_t)fftSize);
+        spectrum.resize((size_t)fftSize);
+        historyPos = 0;
+        samplesToHop = hopSize;
+    }
+
+    void analyse(Snapshot& snapshot) {
+        const int mask = fftSize - 1;
+        // oldest sample first, windowed
+        for (int n = 0; n < fftSize; ++n) {
+            const int pos = (historyPos + n) & mask;
+            const float w = window[(size_t)n];
+            fftInput[(size_t)n] = { dryHistory[(size_t)pos] * w, outHistory[(size_t)pos] * w };
+        }
+        fft->perform(fftInput.data(), spectrum.data(), false);
+
+        for (int b = 0; b < numBands; ++b) {
+            float dryEnergy = 0.0f, outEnergy = 0.0f;
+            for (int k = bandEdges[(size_t)b]; k < bandEdges[(size_t)b + 1]; ++k) {
+                // untangle the two real spectra: Z[k] +- conj(Z[N-k])
+                const auto z = spectrum[(size_t)k];
+                const auto zc = std::conj(spectrum[(size_t)((fftSize - k) & mask)]);
+                dryEnergy += std::norm(z + zc);
+                outEnergy += std::norm(z - zc);
+            }
+            snapshot.input[(size_t)b] = quantise(0.25f * powerScale * dryEnergy);
+            snapshot.output[(size_t)b] = quantise(0.25f * powerScale * outEnergy);
+        }
+    }
+
+    static juce::uint8 quantise(float power) {
+        float db = 10.0f * std::log10(power + 1.0e-14f);
+        return (juce::uint8)juce::jlimit(0, 255, juce::roundToInt(2.0f * (db + 120.0f)));
+    }
+
+    // audio thread -> editor
+    std::atomic<double> sampleRate { 48000.0 };
+    std::atomic<bool> active { false };
+    juce::AbstractFifo queue { ringSize };
+    std::vector<float> dryRing, outRing;
+
+    // editor only
+    double analysisRate = 0.0;
+    int hopSize = 480;
+    int fftOrder = 0;
+    int fftSize = 0;
+    float powerScale = 1.0f;
+    std::vector<float> window;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<std::complex<float>> fftInput, spectrum;
+    std::array<int, numBands + 1> bandEdges {};
+    std::vector<float> dryHistory, outHistory;
+    int historyPos = 0;
+    int samplesToHop = 480;
+};
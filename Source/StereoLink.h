@@ -0,0 +1,121 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+// Linked stereo: the model only runs on mid, and side follows mid's broadband gain.
+// The mid channel publishes one gain per hop, the side channel consumes it for the same hop.
+// Both sides run either on the audio thread or on two workers, so the gain queue is SPSC.
+// Every gain carries its hop number: should the queue ever be full, that hop's gain is
+// dropped and counted, and side holds its previous gain for it instead of falling out of step.
+class StereoLink {
+public:
+    // not real-time safe. modelDelay: how far the model's output lags its input, in model-rate
+    // samples, the longest one setModelDelay() will be asked for. maxBacklogHops: how far side
+    // can fall behind mid, i.e. every hop the side channel's FIFOs can hold
+    void prepare(int newFrameLength, int modelDelay, int maxBacklogHops) {
+        frameLength = newFrameLength;
+        gainFifo.setTotalSize(maxBacklogHops + 1);
+        gains.assign((size_t)gainFifo.getTotalSize(), {});
+        delayedMid.assign(frameLength, 0.0f);
+        midDelay.reserve((size_t)modelDelay);
+        sideDelay.reserve((size_t)modelDelay);
+        setModelDelay(modelDelay);
+    }
+
+    // while neither side runs; doesn't allocate up to prepare()'s modelDelay
+    void setModelDelay(int modelDelay) {
+        midDelay.assign(modelDelay, 0.0f);
+        sideDelay.assign(modelDelay, 0.0f);
+        reset();
+    }
+
+    void reset() {
+        gainFifo.reset();
+        std::fill(midDelay.begin(), midDelay.end(), 0.0f);
+        std::fill(sideDelay.begin(), sideDelay.end(), 0.0f);
+        midDelayPos = 0;
+        sideDelayPos = 0;
+        lastGain = 1.0f;
+        midHops.store(0);
+        sideHops = 0;
+    }
+
+    // gains dropped because side was too far behind
+    juce::uint32 getDroppedGainCount() const { return droppedGains.load(); }
+
+    // mid channel, right after inference; false if the gain had to be dropped
+    bool publishGain(const float* midIn, const float* midOut) {
+        delay(midDelay, midDelayPos, midIn, delayedMid.data());
+
+        float inEnergy = 0.0f, outEnergy = 0.0f;
+        for (int i = 0; i < frameLength; ++i) {
+            inEnergy += delayedMid[i] * delayedMid[i];
+            outEnergy += midOut[i] * midOut[i];
+        }
+        float gain = inEnergy > 1.0e-12f ? std::sqrt(outEnergy / inEnergy) : 1.0f;
+
+        const auto hop = midHops.load(std::memory_order_relaxed);
+        int start1, size1, start2, size2;
+        gainFifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 > 0) gains[(size_t)start1] = { hop, juce::jlimit(0.0f, 1.0f, gain) };
+        gainFifo.finishedWrite(size1);
+        // counted even when dropped, so side knows the hop has passed
+        midHops.store(hop + 1, std::memory_order_release);
+        if (size1 > 0) return true;
+        droppedGains.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // hops mid is ahead of side, i.e. how many side can process now
+    int getNumGains() const { return (int)(midHops.load(std::memory_order_acquire) - sideHops); }
+
+    // side channel, in place of inference; ramps from the previous hop's gain to avoid zipper noise
+    void applyGain(const float* sideIn, float* sideOut) {
+        // the queue's head is this hop's gain, unless that one was dropped
+        float gain = lastGain;
+        int start1, size1, start2, size2;
+        gainFifo.prepareToRead(1, start1, size1, start2, size2);
+        const bool current = size1 > 0 && gains[(size_t)start1].hop == sideHops;
+        if (current) gain = gains[(size_t)start1].gain;
+        gainFifo.finishedRead(current ? size1 : 0);
+        ++sideHops;
+
+        delay(sideDelay, sideDelayPos, sideIn, sideOut);
+        const float step = (gain - lastGain) / (float)frameLength;
+        for (int i = 0; i < frameLength; ++i)
+            sideOut[i] *= lastGain + step * (float)(i + 1);
+        lastGain = gain;
+    }
+
+private:
+    void delay(std::vector<float>& line, int& pos, const float* in, float* out) {
+        if (line.empty()) {
+            juce::FloatVectorOperations::copy(out, in, frameLength);
+            return;
+        }
+        for (int i = 0; i < frameLength; ++i) {
+            float x = in[i];
+            out[i] = line[pos];
+            line[pos] = x;
+            if (++pos == (int)line.size()) pos = 0;
+        }
+    }
+
+    struct HopGain {
+        juce::uint32 hop = 0;
+        float gain = 1.0f;
+    };
+
+    juce::AbstractFifo gainFifo { 256 };
+    std::vector<HopGain> gains;
+    std::atomic<juce::uint32> midHops { 0 }; // published or dropped
+    juce::uint32 sideHops = 0;
+    std::atomic<juce::uint32> droppedGains { 0 };
+    std::vector<float> midDelay, sideDelay, delayedMid;
+    int midDelayPos = 0, sideDelayPos = 0;
+    int frameLength = 480;
+    float lastGain = 1.0f;
+};
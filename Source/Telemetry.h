@@ -0,0 +1,174 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Lock-free counters written from the audio thread, the channel pool and the inference
+// workers, and read from anywhere. Writers only do relaxed atomic stores and adds;
+// everything that needs sorting or formatting happens on the reader's side in snapshot().
+class Telemetry {
+public:
+    static constexpr int maxChannels = 8;
+    static constexpr int historySize = 1024; // hops the rolling p99 looks back over
+    static constexpr int numTierCounters = 4;
+
+    struct Snapshot {
+        float lastHopMs = 0.0f;
+        float maxHopMs = 0.0f;
+        float p99HopMs = 0.0f;
+        juce::uint64 inferredHops = 0;
+        juce::uint64 underruns = 0;
+        juce::uint64 overflows = 0;
+        juce::uint64 resamplerIn = 0;  // host-rate samples into the resampler
+        juce::uint64 resamplerOut = 0; // model-rate samples out of it
+        int numChannels = 0;
+        std::array<int, maxChannels> inputFill {};
+        std::array<int, maxChannels> outputFill {};
+        // hops per LoadGovernor::Counter: full, eager gate, held gain, expander
+        std::array<juce::uint64, numTierCounters> tierHops {};
+
+        juce::String toJson() const {
+            juce::String json;
+            json << "{\"last_hop_ms\":" << lastHopMs << ",\"max_hop_ms\":" << maxHopMs
+                 << ",\"p99_hop_ms\":" << p99HopMs << ",\"inferred_hops\":" << (juce::int64)inferredHops
+                 << ",\"underruns\":" << (juce::int64)underruns << ",\"overflows\":" << (juce::int64)overflows
+                 << ",\"resampler_in\":" << (juce::int64)resamplerIn
+                 << ",\"resampler_out\":" << (juce::int64)resamplerOut << ",\"input_fill\":[";
+            for (int ch = 0; ch < numChannels; ++ch) json << (ch > 0 ? "," : "") << inputFill[(size_t)ch];
+            json << "],\"output_fill\":[";
+            for (int ch = 0; ch < numChannels; ++ch) json << (ch > 0 ? "," : "") << outputFill[(size_t)ch];
+            json << "],\"tier_hops\":[";
+            for (int t = 0; t < numTierCounters; ++t) json << (t > 0 ? "," : "") << (juce::int64)tierHops[(size_t)t];
+            json << "]}";
+            return json;
+        }
+    };
+
+    void reset() {
+        lastHopMs.store(0.0f);
+        maxHopMs.store(0.0f);
+        inferredHops.store(0);
+        underruns.store(0);
+        overflows.store(0);
+        resamplerIn.store(0);
+        resamplerOut.store(0);
+        historyCount.store(0);
+        for (auto& h : history) h.store(0.0f);
+        for (auto& t : tierHops) t.store(0);
+    }
+
+    void setNumChannels(int n) { numChannels.store(juce::jlimit(0, maxChannels, n)); }
+
+    // after a run of hops, with the time the whole run took
+    void recordInference(double ms, int numHops) {
+        if (numHops <= 0) return;
+        float perHop = (float)(ms / numHops);
+        lastHopMs.store(perHop, std::memory_order_relaxed);
+        float currentMax = maxHopMs.load(std::memory_order_relaxed);
+        while (perHop > currentMax && !maxHopMs.compare_exchange_weak(currentMax, perHop, std::memory_order_relaxed)) {}
+        auto index = historyCount.fetch_add((juce::uint32)numHops, std::memory_order_relaxed);
+        for (int i = 0; i < numHops; ++i)
+            history[(index + (juce::uint32)i) % historySize].store(perHop, std::memory_order_relaxed);
+        inferredHops.fetch_add((juce::uint64)numHops, std::memory_order_relaxed);
+    }
+
+    void recordFill(int channel, int inputSamples, int outputSamples) {
+        if (channel < 0 || channel >= maxChannels) return;
+        inputFill[(size_t)channel].store(inputSamples, std::memory_order_relaxed);
+        outputFill[(size_t)channel].store(outputSamples, std::memory_order_relaxed);
+    }
+
+    // output that had to be zero-padded after the pipeline had filled
+    void recordUnderrun() { underruns.fetch_add(1, std::memory_order_relaxed); }
+    // input that had to be dropped because a FIFO was full
+    void recordOverflow() { overflows.fetch_add(1, std::memory_order_relaxed); }
+
+    // hops the load governor spent in each tier
+    void recordTierHops(int counter, int numHops) {
+        if (counter < 0 || counter >= numTierCounters) return;
+        tierHops[(size_t)counter].fetch_add((juce::uint64)numHops, std::memory_order_relaxed);
+    }
+
+    void recordResampler(int hostSamples, int modelSamples) {
+        resamplerIn.fetch_add((juce::uint64)hostSamples, std::memory_order_relaxed);
+        resamplerOut.fetch_add((juce::uint64)modelSamples, std::memory_order_relaxed);
+    }
+
+    // any thread, not real-time safe (allocates for the percentile)
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.lastHopMs = lastHopMs.load();
+        s.maxHopMs = maxHopMs.load();
+        s.inferredHops = inferredHops.load();
+        s.underruns = underruns.load();
+        s.overflows = overflows.load();
+        s.resamplerIn = resamplerIn.load();
+        s.resamplerOut = resamplerOut.load();
+        s.numChannels = numChannels.load();
+        for (int ch = 0; ch < maxChannels; ++ch) {
+            s.inputFill[(size_t)ch] = inputFill[(size_t)ch].load();
+            s.outputFill[(size_t)ch] = outputFill[(size_t)ch].load();
+        }
+        for (int t = 0; t < numTierCounters; ++t)
+            s.tierHops[(size_t)t] = tierHops[(size_t)t].load();
+
+        int count = (int)juce::jmin<juce::uint32>(historyCount.load(), (juce::uint32)historySize);
+        if (count > 0) {
+            std::vector<float> times((size_t)count);
+            for (int i = 0; i < count; ++i) times[(size_t)i] = history[(size_t)i].load();
+            auto p99 = times.begin() + (std::ptrdiff_t)((count - 1) * 99 / 100);
+            std::nth_element(times.begin(), p99, times.end());
+            s.p99HopMs = *p99;
+        }
+        return s;
+    }
+
+private:
+    std::atomic<float> lastHopMs { 0.0f };
+    std::atomic<float> maxHopMs { 0.0f };
+    std::atomic<juce::uint64> inferredHops { 0 };
+    std::atomic<juce::uint64> underruns { 0 };
+    std::atomic<juce::uint64> overflows { 0 };
+    std::atomic<juce::uint64> resamplerIn { 0 };
+    std::atomic<juce::uint64> resamplerOut { 0 };
+    std::atomic<int> numChannels { 0 };
+    std::array<std::atomic<int>, maxChannels> inputFill {};
+    std::array<std::atomic<int>, maxChannels> outputFill {};
+    std::array<std::atomic<juce::uint64>, numTierCounters> tierHops {};
+    std::array<std::atomic<float>, historySize> history {};
+    std::atomic<juce::uint32> historyCount { 0 };
+};
+
+// Appends one JSON line per interval to a file, from its own low-priority thread,
+// so the audio thread never touches the disk.
+class TelemetryDump : private juce::Thread {
+public:
+    TelemetryDump(const Telemetry& source, const juce::File& file, int newIntervalMs)
+        : juce::Thread("Alt Denoiser Telemetry"), telemetry(source), stream(file), intervalMs(juce::jmax(10, newIntervalMs)) {
+        if (stream.failedToOpen()) {
+            DBG("Failed to open telemetry file: " + file.getFullPathName());
+            return;
+        }
+        startThread(juce::Thread::Priority::low);
+    }
+
+    ~TelemetryDump() override { stopThread(1000); }
+
+private:
+    void run() override {
+        while (!threadShouldExit()) {
+            wait(intervalMs);
+            auto line = "{\"time_ms\":" + juce::String(juce::Time::currentTimeMillis())
+                      + ",\"telemetry\":" + telemetry.snapshot().toJson() + "}\n";
+            stream.writeText(line, false, false, nullptr);
+            stream.flush();
+        }
+    }
+
+    const Telemetry& telemetry;
+    juce::FileOutputStream stream;
+    int intervalMs;
+};
@@ -0,0 +1,94 @@
+#include "WakeSemaphore.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+ #include <ctime>
+#endif
+
+// sem_post, dispatch_semaphore_signal and ReleaseSemaphore never take a user-space lock
+struct WakeSemaphore::Native {
+#if JUCE_WINDOWS
+    Native() { handle = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr); }
+    ~Native() { CloseHandle(handle); }
+    void post(int n) { ReleaseSemaphore(handle, n, nullptr); }
+    bool wait(int timeoutMs) {
+        return WaitForSingleObject(handle, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs) == WAIT_OBJECT_0;
+    }
+    HANDLE handle;
+#elif JUCE_MAC || JUCE_IOS
+    Native() { sema = dispatch_semaphore_create(0); }
+    ~Native() { dispatch_release(sema); }
+    void post(int n) { while (--n >= 0) dispatch_semaphore_signal(sema); }
+    bool wait(int timeoutMs) {
+        auto until = timeoutMs < 0 ? DISPATCH_TIME_FOREVER : dispatch_time(DISPATCH_TIME_NOW, (int64_t)timeoutMs * 1000000);
+        return dispatch_semaphore_wait(sema, until) == 0;
+    }
+    dispatch_semaphore_t sema;
+#else
+    Native() { sem_init(&sema, 0, 0); }
+    ~Native() { sem_destroy(&sema); }
+    void post(int n) { while (--n >= 0) sem_post(&sema); }
+    bool wait(int timeoutMs) {
+        if (timeoutMs < 0) {
+            while (sem_wait(&sema) != 0)
+                if (errno != EINTR) return false;
+            return true;
+        }
+        timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += timeoutMs / 1000;
+        until.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+        if (until.tv_nsec >= 1000000000) {
+            ++until.tv_sec;
+            until.tv_nsec -= 1000000000;
+        }
+        while (sem_timedwait(&sema, &until) != 0)
+            if (errno != EINTR) return false;
+        return true;
+    }
+    sem_t sema;
+#endif
+};
+
+WakeSemaphore::WakeSemaphore() : native(std::make_unique<Native>()) {
+}
+
+WakeSemaphore::~WakeSemaphore() {
+}
+
+void WakeSemaphore::notify() {
+    int old = count.load(std::memory_order_relaxed);
+    do {
+        if (old > 0) return; // a wake-up is already pending
+    } while (!count.compare_exchange_weak(old, old + 1, std::memory_order_release, std::memory_order_relaxed));
+    if (old < 0) native->post(1);
+}
+
+void WakeSemaphore::signal(int n) {
+    if (n <= 0) return;
+    const int old = count.fetch_add(n, std::memory_order_release);
+    const int sleepers = juce::jmin(n, -old);
+    if (sleepers > 0) native->post(sleepers);
+}
+
+bool WakeSemaphore::wait(int timeoutMs) {
+    if (count.fetch_sub(1, std::memory_order_acquire) > 0) return true;
+    if (native->wait(timeoutMs)) return true;
+
+    // timed out: give the sleeper slot back, unless a signal has already counted on it
+    int old = count.load(std::memory_order_relaxed);
+    while (old < 0) {
+        if (count.compare_exchange_weak(old, old + 1, std::memory_order_relaxed)) return false;
+    }
+    // that signal's post is on its way
+    native->wait(-1);
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+
+// Counting semaphore the audio thread can signal: no lock, no allocation, and a system call
+// only when a thread is actually asleep on it. The count lives in an atomic; the OS semaphore
+// underneath (POSIX on Linux, dispatch on macOS, a kernel semaphore on Windows) is only
+// touched by signals that have a sleeper to wake and by waits that find nothing pending.
+class WakeSemaphore {
+public:
+    WakeSemaphore();
+    ~WakeSemaphore();
+
+    // any thread, real-time safe: wakes one sleeping thread, or leaves a single wake-up pending
+    // if none sleeps; repeated calls while nobody sleeps don't pile up
+    void notify();
+    // any thread, real-time safe: wakes up to count threads, pending or not, e.g. to shut down
+    void signal(int count);
+    // blocks until signalled or timeoutMs has passed (< 0 waits for ever); false on timeout
+    bool wait(int timeoutMs);
+
+private:
+    struct Native;
+    std::unique_ptr<Native> native;
+    std::atomic<int> count { 0 }; // < 0: that many threads asleep
+
+    JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+};
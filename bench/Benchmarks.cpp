@@ -0,0 +1,396 @@
+// Headless benchmark suite, prints one JSON document:
+//   frames       - df_process_frame time per hop, with percentiles and a histogram
+//   ring_buffer  - frame FIFO throughput on the sync path's access pattern
+//   resampler    - host <-> 48 kHz round trips at 44.1 / 88.2 / 96 / 192 kHz: cost, delay and
+//                  the residual left around 1, 10 and 18 kHz tones, generic vs polyphase vs halfband
+//   flight_recorder - cost of one recorded event, and its share of a 128-sample block
+//   process_block - full AltDenoiserProcessor::processBlock per host block size,
+//                   with the headroom left before the callback deadline
+//
+//   AltDenoiserBench [--frames n] [--seconds s] [--rate hz] [--margin 0..1] [--out file.json]
+#include <juce_core/juce_core.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include "DeepFilterNetProcessor.h"
+#include "HalfbandResampler.h"
+#include "PolyphaseResampler.h"
+#include "FlightRecorder.h"
+#include "RingBuffer.h"
+#include "Resampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+    volatile float benchSink = 0.0f;
+
+    double ticksToMicroseconds(juce::int64 ticks) {
+        return (double)ticks * 1.0e6 / (double)juce::Time::getHighResolutionTicksPerSecond();
+    }
+
+    // noise with a slowly modulated tone on top, so the model has something to keep
+    void fillTestSignal(juce::Random& random, float* data, int numSamples, double& phase, double sampleRate) {
+        for (int i = 0; i < numSamples; ++i) {
+            float noise = (random.nextFloat() * 2.0f - 1.0f) * 0.05f;
+            float tone = 0.2f * (float)std::sin(phase) * (0.5f + 0.5f * (float)std::sin(phase * 0.0005));
+            phase += juce::MathConstants<double>::twoPi * 220.0 / sampleRate;
+            data[i] = noise + tone;
+        }
+    }
+
+    juce::var summarize(std::vector<double> values) {
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        if (values.empty()) return result.get();
+        std::sort(values.begin(), values.end());
+        auto percentile = [&](double p) { return values[(size_t)std::min((double)values.size() - 1.0, p * (double)values.size())]; };
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        result->setProperty("count", (int)values.size());
+        result->setProperty("mean_us", sum / (double)values.size());
+        result->setProperty("p50_us", percentile(0.50));
+        result->setProperty("p99_us", percentile(0.99));
+        result->setProperty("max_us", values.back());
+        return result.get();
+    }
+
+    double getProperty(const juce::var& object, const char* name) {
+        return (double)object.getProperty(name, 0.0);
+    }
+
+    juce::var benchFrames(int numFrames) {
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        DeepFilterNetProcessor df;
+        if (!df.initialize() || !df.adoptPending()) {
+            result->setProperty("error", "model failed to load");
+            return result.get();
+        }
+
+        const int frameLength = df.getFrameLength();
+        std::vector<float> input(frameLength), output(frameLength);
+        std::vector<double> times;
+        times.reserve(numFrames);
+        juce::Random random(1);
+        double phase = 0.0;
+
+        // the first frames are slower while the network warms up
+        for (int i = 0; i < 50; ++i) {
+            fillTestSignal(random, input.data(), frameLength, phase, (double)df.getSampleRate());
+            df.processFrame(input.data(), output.data());
+        }
+        for (int i = 0; i < numFrames; ++i) {
+            fillTestSignal(random, input.data(), frameLength, phase, (double)df.getSampleRate());
+            auto start = juce::Time::getHighResolutionTicks();
+            df.processFrame(input.data(), output.data());
+            times.push_back(ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start));
+        }
+
+        // 100 us buckets up to 10 ms, the last one catches everything above
+        const double bucketUs = 100.0;
+        std::vector<int> counts(101, 0);
+        for (double t : times)
+            ++counts[(size_t)std::min(100, (int)(t / bucketUs))];
+        juce::Array<juce::var> histogram;
+        for (int i = 0; i < (int)counts.size(); ++i) {
+            if (counts[(size_t)i] == 0) continue;
+            juce::DynamicObject::Ptr bucket = new juce::DynamicObject();
+            bucket->setProperty("from_us", i * bucketUs);
+            bucket->setProperty("count", counts[(size_t)i]);
+            histogram.add(bucket.get());
+        }
+
+        auto stats = summarize(times);
+        double hopUs = frameLength * 1.0e6 / df.getSampleRate();
+        result->setProperty("frame_length", frameLength);
+        result->setProperty("hop_us", hopUs);
+        result->setProperty("stats", stats);
+        result->setProperty("realtime_factor", hopUs / juce::jmax(1.0e-9, getProperty(stats, "mean_us")));
+        result->setProperty("histogram", histogram);
+        return result.get();
+    }
+
+    juce::var benchRingBuffer(double seconds) {
+        juce::Array<juce::var> results;
+        const int frameLength = 480;
+        const int totalSamples = (int)(seconds * 48000.0);
+
+        for (int blockSize : { 32, 128, 512, 2048 }) {
+            RingBuffer input, output;
+            input.setSize(48000, frameLength);
+            output.setSize(48000, frameLength);
+            std::vector<float> block(blockSize, 0.25f);
+            float sink = 0.0f;
+
+            auto start = juce::Time::getHighResolutionTicks();
+            for (int done = 0; done < totalSamples; done += blockSize) {
+                input.write(block.data(), blockSize);
+                while (input.getNumReady() >= frameLength) {
+                    const float* in = input.readSpan(frameLength);
+                    float* out = output.writeSpan(frameLength);
+                    std::copy(in, in + frameLength, out);
+                    sink += out[0];
+                    input.discard(frameLength);
+                    output.commit(frameLength);
+                }
+                output.read(block.data(), blockSize);
+            }
+            double us = ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start);
+
+            juce::DynamicObject::Ptr result = new juce::DynamicObject();
+            result->setProperty("block_size", blockSize);
+            result->setProperty("ns_per_sample", us * 1000.0 / totalSamples);
+            result->setProperty("msamples_per_s", totalSamples / juce::jmax(1.0e-9, us));
+            benchSink = sink;
+            results.add(result.get());
+        }
+        return results;
+    }
+
+    // host block in, host block out, through 48 kHz and back with a pass-through in the middle
+    using RoundTrip = std::function<void(float* data, int numSamples)>;
+
+    RoundTrip makeRoundTrip(const juce::String& path, double rate, int blockSize) {
+        auto in48k = std::make_shared<std::vector<float>>((size_t)(4 * blockSize + 128));
+        auto out48k = std::make_shared<std::vector<float>>((size_t)(4 * blockSize + 128));
+        if (path == "halfband") {
+            auto halfband = std::make_shared<HalfbandResampler>();
+            return [=](float* data, int n) {
+                int m = halfband->decimate(data, in48k->data(), n);
+                halfband->interpolate(in48k->data(), m, data, n);
+            };
+        }
+        if (path == "polyphase") {
+            auto polyphase = std::make_shared<PolyphaseResampler>();
+            polyphase->prepare(rate, 48000.0);
+            return [=](float* data, int n) {
+                int m = polyphase->toModelRate(data, in48k->data(), n);
+                polyphase->fromModelRate(in48k->data(), m, data, n);
+            };
+        }
+        auto resampler = std::make_shared<Resampler<1, 1>>(rate, 48000.0);
+        return [=](float* data, int n) {
+            float* srcIn[] = { data };          float* srcOut[] = { data };
+            float* tgtIn[] = { in48k->data() }; float* tgtOut[] = { out48k->data() };
+            resampler->process(srcIn, srcOut, tgtIn, tgtOut, n,
+                [](float* const* input, float* const* output, int count) { std::copy(input[0], input[0] + count, output[0]); });
+        };
+    }
+
+    // where an impulse comes out, in host samples
+    int measureRoundTripDelay(RoundTrip roundTrip, double rate, int blockSize) {
+        std::vector<float> signal((size_t)juce::roundToInt(rate * 0.1), 0.0f);
+        signal[0] = 1.0f;
+        for (int pos = 0; pos < (int)signal.size(); pos += blockSize)
+            roundTrip(signal.data() + pos, juce::jmin(blockSize, (int)signal.size() - pos));
+        auto peak = std::max_element(signal.begin(), signal.end(), [](float a, float b) { return std::abs(a) < std::abs(b); });
+        return (int)std::distance(signal.begin(), peak);
+    }
+
+    // a tone through the round trip: fits a sine of the same frequency to what comes out, whatever
+    // its delay, and returns the rest (aliases, images, ripple, noise) in dB below the tone
+    double measureToneResidual(RoundTrip roundTrip, double rate, int blockSize, double frequency) {
+        const int length = juce::roundToInt(rate);
+        std::vector<float> signal((size_t)length);
+        const double w = juce::MathConstants<double>::twoPi * frequency / rate;
+        for (int i = 0; i < length; ++i)
+            signal[(size_t)i] = 0.5f * (float)std::sin(w * i);
+        for (int pos = 0; pos < length; pos += blockSize)
+            roundTrip(signal.data() + pos, juce::jmin(blockSize, length - pos));
+
+        // least squares for a * sin + b * cos over the settled half
+        double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0;
+        for (int i = length / 2; i < length; ++i) {
+            double sn = std::sin(w * i), cs = std::cos(w * i), y = signal[(size_t)i];
+            ss += sn * sn; cc += cs * cs; sc += sn * cs; ys += y * sn; yc += y * cs;
+        }
+        double det = ss * cc - sc * sc;
+        double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+        double tone = 0.0, residual = 0.0;
+        for (int i = length / 2; i < length; ++i) {
+            double fit = a * std::sin(w * i) + b * std::cos(w * i);
+            tone += fit * fit;
+            residual += (signal[(size_t)i] - fit) * (signal[(size_t)i] - fit);
+        }
+        return 10.0 * std::log10(juce::jmax(residual, 1.0e-30) / juce::jmax(tone, 1.0e-30));
+    }
+
+    juce::var benchResampler(double seconds) {
+        juce::Array<juce::var> results;
+        const int blockSize = 512;
+
+        for (double rate : { 44100.0, 88200.0, 96000.0, 192000.0 }) {
+            const int totalSamples = (int)(seconds * rate);
+            std::vector<float> block(blockSize);
+            juce::Random random(2);
+            double phase = 0.0;
+            fillTestSignal(random, block.data(), blockSize, phase, rate);
+
+            // 96 kHz runs on the fixed 2:1 path in the plugin, measure that too
+            juce::StringArray paths { "resampler", "polyphase" };
+            if (rate == 96000.0) paths.add("halfband");
+            for (auto& path : paths) {
+                auto roundTrip = makeRoundTrip(path, rate, blockSize);
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int done = 0; done < totalSamples; done += blockSize)
+                    roundTrip(block.data(), blockSize);
+                double us = ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start);
+
+                juce::DynamicObject::Ptr result = new juce::DynamicObject();
+                result->setProperty("sample_rate", rate);
+                result->setProperty("path", path);
+                result->setProperty("ns_per_sample", us * 1000.0 / totalSamples);
+                result->setProperty("delay_samples", measureRoundTripDelay(makeRoundTrip(path, rate, blockSize), rate, blockSize));
+                if (path == "polyphase") {
+                    PolyphaseResampler polyphase;
+                    polyphase.prepare(rate, 48000.0);
+                    result->setProperty("reported_delay", polyphase.getLatency());
+                }
+                for (double frequency : { 1000.0, 10000.0, 18000.0 })
+                    result->setProperty("residual_db_" + juce::String(juce::roundToInt(frequency / 1000.0)) + "k",
+                                        measureToneResidual(makeRoundTrip(path, rate, blockSize), rate, blockSize, frequency));
+                results.add(result.get());
+            }
+        }
+        return results;
+    }
+
+    // cost of one event on the way in; processBlock records a few per channel and block
+    juce::var benchFlightRecorder() {
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        auto recorder = std::make_unique<FlightRecorder>();
+        const int numEvents = 1 << 20;
+        auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numEvents; ++i)
+            recorder->span(FlightRecorder::Type::inference, start, i & 7, 1.0f);
+        double us = ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start);
+        double nsPerEvent = us * 1000.0 / numEvents;
+        result->setProperty("ns_per_event", nsPerEvent);
+        // stereo through a resampler: block, two legs, inference and FIFO level per channel
+        const int eventsPerBlock = 1 + 2 * 4;
+        result->setProperty("overhead_128_at_48k", eventsPerBlock * nsPerEvent * 1.0e-9 / (128.0 / 48000.0));
+        return result.get();
+    }
+
+    void setBoolParameter(juce::AudioProcessor& processor, const juce::String& id, bool value) {
+        for (auto* param : processor.getParameters())
+            if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+                if (withId->paramID == id)
+                    withId->setValueNotifyingHost(value ? 1.0f : 0.0f);
+    }
+
+    juce::var benchProcessBlock(double sampleRate, double seconds, double margin) {
+        juce::DynamicObject::Ptr result = new juce::DynamicObject();
+        AltDenoiserProcessor processor;
+
+        // the model loads in the background; wait for it so we time the wet path
+        auto waitStart = juce::Time::getMillisecondCounterHiRes();
+        while (processor.getModelState() == ModelLoader::State::loading
+               && juce::Time::getMillisecondCounterHiRes() - waitStart < 60000.0)
+            juce::Thread::sleep(10);
+        if (processor.getModelState() != ModelLoader::State::ready) {
+            result->setProperty("error", "model failed to load");
+            return result.get();
+        }
+        result->setProperty("sample_rate", sampleRate);
+        result->setProperty("model_load_ms", processor.getModelLoadTimeMs());
+
+        for (bool async : { false, true }) {
+            juce::Array<juce::var> blocks;
+            int smallestSafe = 0;
+
+            for (int blockSize = 32; blockSize <= 4096; blockSize *= 2) {
+                setBoolParameter(processor, "async_mode", async);
+                processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+                processor.prepareToPlay(sampleRate, blockSize);
+
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer midi;
+                juce::Random random(3);
+                double phase = 0.0;
+                auto runBlock = [&] {
+                    fillTestSignal(random, buffer.getWritePointer(0), blockSize, phase, sampleRate);
+                    buffer.copyFrom(1, 0, buffer, 0, 0, blockSize);
+                    auto start = juce::Time::getHighResolutionTicks();
+                    processor.processBlock(buffer, midi);
+                    return ticksToMicroseconds(juce::Time::getHighResolutionTicks() - start);
+                };
+
+                // get past the mode switch, the FIFO fill and the wet fade-in
+                int warmupBlocks = (int)(0.5 * sampleRate) / blockSize + 4;
+                for (int i = 0; i < warmupBlocks; ++i) runBlock();
+
+                int numBlocks = juce::jmax(50, (int)(seconds * sampleRate) / blockSize);
+                std::vector<double> times;
+                times.reserve(numBlocks);
+                for (int i = 0; i < numBlocks; ++i) times.push_back(runBlock());
+                processor.releaseResources();
+
+                auto stats = summarize(times);
+                double deadlineUs = blockSize * 1.0e6 / sampleRate;
+                double worst = getProperty(stats, "max_us");
+                bool safe = worst < deadlineUs * (1.0 - margin);
+                if (safe && smallestSafe == 0) smallestSafe = blockSize;
+
+                juce::DynamicObject::Ptr block = new juce::DynamicObject();
+                block->setProperty("block_size", blockSize);
+                block->setProperty("deadline_us", deadlineUs);
+                block->setProperty("stats", stats);
+                // fraction of the callback left over, 1 = idle, <= 0 = missed deadline
+                block->setProperty("headroom_p99", 1.0 - getProperty(stats, "p99_us") / deadlineUs);
+                block->setProperty("headroom_max", 1.0 - worst / deadlineUs);
+                block->setProperty("safe", safe);
+                block->setProperty("late_frames", (int)processor.getLateFrameCount());
+                blocks.add(block.get());
+            }
+
+            juce::DynamicObject::Ptr mode = new juce::DynamicObject();
+            mode->setProperty("blocks", blocks);
+            mode->setProperty("smallest_safe_block", smallestSafe);
+            result->setProperty(async ? "async" : "sync", mode.get());
+        }
+        return result.get();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInit; // the processor's parameters need the message manager
+
+    int numFrames = 2000;
+    double seconds = 10.0;
+    double sampleRate = 48000.0;
+    double margin = 0.3; // keep 30% of the callback for the host and other plugins
+    juce::File outputFile;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        juce::String arg(argv[i]), value(argv[i + 1]);
+        if (arg == "--frames") numFrames = juce::jmax(1, value.getIntValue());
+        else if (arg == "--seconds") seconds = juce::jmax(0.1, value.getDoubleValue());
+        else if (arg == "--rate") sampleRate = value.getDoubleValue();
+        else if (arg == "--margin") margin = juce::jlimit(0.0, 0.95, value.getDoubleValue());
+        else if (arg == "--out") outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+    }
+
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty("version", ALT_DENOISER_VERSION);
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("num_cpus", juce::SystemStats::getNumCpus());
+    report->setProperty("frames", benchFrames(numFrames));
+    report->setProperty("ring_buffer", benchRingBuffer(seconds));
+    report->setProperty("resampler", benchResampler(seconds));
+    report->setProperty("flight_recorder", benchFlightRecorder());
+    report->setProperty("process_block", benchProcessBlock(sampleRate, seconds, margin));
+    report->setProperty("safety_margin", margin);
+
+    auto json = juce::JSON::toString(report.get());
+    if (outputFile != juce::File()) {
+        if (!outputFile.replaceWithText(json)) {
+            std::fprintf(stderr, "can't write %s\n", outputFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    } else {
+        std::printf("%s\n", json.toRawUTF8());
+    }
+    return 0;
+}
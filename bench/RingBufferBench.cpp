@@ -0,0 +1,112 @@
+// Ring buffer microbenchmark: the old SimpleFifo against RingBuffer, on the
+// sync path's access pattern (push a host block, pull 480-sample frames, pull a block).
+#include "RingBuffer.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// the FIFO ChannelProcessor used before RingBuffer, kept verbatim for comparison
+class SimpleFifo {
+public:
+    void setSize(int size) {
+        buffer.resize(size, 0.0f);
+        writePos = 0; readPos = 0; samplesInFifo = 0;
+    }
+
+    void push(const float* data, int numSamples) {
+        for (int i = 0; i < numSamples; ++i) {
+            buffer[writePos] = data[i];
+            writePos = (writePos + 1) % buffer.size();
+        }
+        samplesInFifo += numSamples;
+        if (samplesInFifo > buffer.size()) samplesInFifo = buffer.size();
+    }
+
+    void peek(float* dest, int numSamples) {
+        int tempRead = readPos;
+        for (int i = 0; i < numSamples; ++i) {
+            dest[i] = buffer[tempRead];
+            tempRead = (tempRead + 1) % buffer.size();
+        }
+    }
+
+    void discard(int numSamples) {
+        readPos = (readPos + numSamples) % buffer.size();
+        samplesInFifo -= numSamples;
+    }
+
+    int getAvailable() const { return samplesInFifo; }
+
+private:
+    std::vector<float> buffer;
+    int writePos = 0;
+    int readPos = 0;
+    int samplesInFifo = 0;
+};
+
+constexpr int frameLength = 480;
+constexpr int numBlocks = 200000;
+volatile float benchSink = 0.0f;
+
+// stands in for df_process_frame so the compiler can't drop the frame
+float consume(const float* in, float* out) {
+    float sum = 0.0f;
+    for (int i = 0; i < frameLength; ++i) { out[i] = in[i]; sum += in[i]; }
+    return sum;
+}
+
+template <typename Fn>
+double timeNsPerSample(int blockSize, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < numBlocks; ++b) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ((double)numBlocks * blockSize);
+}
+
+} // namespace
+
+int main() {
+    std::printf("%-8s %14s %14s %8s\n", "block", "SimpleFifo ns", "RingBuffer ns", "speedup");
+
+    for (int blockSize : { 32, 64, 128, 256, 512, 1024 }) {
+        std::vector<float> in(blockSize, 0.25f), out(blockSize);
+        std::vector<float> tempIn(frameLength), tempOut(frameLength);
+        float sink = 0.0f;
+
+        SimpleFifo oldIn, oldOut;
+        oldIn.setSize(48000);
+        oldOut.setSize(48000);
+        double oldNs = timeNsPerSample(blockSize, [&] {
+            oldIn.push(in.data(), blockSize);
+            while (oldIn.getAvailable() >= frameLength) {
+                oldIn.peek(tempIn.data(), frameLength);
+                oldIn.discard(frameLength);
+                sink += consume(tempIn.data(), tempOut.data());
+                oldOut.push(tempOut.data(), frameLength);
+            }
+            int n = oldOut.getAvailable() < blockSize ? oldOut.getAvailable() : blockSize;
+            oldOut.peek(out.data(), n);
+            oldOut.discard(n);
+        });
+
+        RingBuffer newIn, newOut;
+        newIn.setSize(48000, frameLength);
+        newOut.setSize(48000, frameLength);
+        double newNs = timeNsPerSample(blockSize, [&] {
+            newIn.write(in.data(), blockSize);
+            while (newIn.getNumReady() >= frameLength) {
+                float* frameOut = newOut.writeSpan(frameLength);
+                sink += consume(newIn.readSpan(frameLength), frameOut);
+                newIn.discard(frameLength);
+                newOut.commit(frameLength);
+            }
+            newOut.read(out.data(), blockSize);
+        });
+
+        benchSink = sink;
+        std::printf("%-8d %14.3f %14.3f %7.2fx\n", blockSize, oldNs, newNs, oldNs / newNs);
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+// Real-time safety audit: runs AltDenoiserProcessor::processBlock across sample rates,
+// block sizes and processing modes, and counts every heap allocation, free and lock taken
+// on the calling thread while it is inside processBlock. Exits non-zero if there was any.
+// Besides each mode's steady state, switches made while playing are audited as cases of
+// their own: async, stereo link and latency mode toggled, and bypass entered and left, which
+// resets the channels that sat it out.
+//
+//   alt-denoiser-rt-audit [--seconds s]
+//
+// On Linux malloc, calloc, realloc, free, the aligned allocators and the pthread mutex and
+// rwlock functions are interposed; operator new and delete end up in malloc and free, so
+// they are caught too, as are the C allocator and libDF. Elsewhere only operator new and
+// delete are replaced, and locks aren't counted. Channels the sync pool hands to helper
+// threads are not watched; the mono runs cover that code path.
+#include <juce_core/juce_core.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "PluginProcessor.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace {
+    thread_local bool auditing = false;
+    std::atomic<int> numAllocations { 0 };
+    std::atomic<int> numFrees { 0 };
+    std::atomic<int> numLocks { 0 };
+
+    void noteAllocation() { if (auditing) numAllocations.fetch_add(1, std::memory_order_relaxed); }
+    void noteFree()       { if (auditing) numFrees.fetch_add(1, std::memory_order_relaxed); }
+    void noteLock()       { if (auditing) numLocks.fetch_add(1, std::memory_order_relaxed); }
+}
+
+#if defined(__linux__)
+extern "C" {
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size) { noteAllocation(); return __libc_malloc(size); }
+    void* calloc(size_t count, size_t size) { noteAllocation(); return __libc_calloc(count, size); }
+    void* realloc(void* ptr, size_t size) { noteAllocation(); return __libc_realloc(ptr, size); }
+    void* aligned_alloc(size_t alignment, size_t size) { noteAllocation(); return __libc_memalign(alignment, size); }
+    void free(void* ptr) { if (ptr != nullptr) noteFree(); __libc_free(ptr); }
+    int posix_memalign(void** ptr, size_t alignment, size_t size) {
+        noteAllocation();
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr != nullptr ? 0 : ENOMEM;
+    }
+
+    // resolved lazily; dlsym itself doesn't go through these
+    #define ALT_AUDIT_FORWARD(name, Arg)                                                   \
+        int name(Arg arg) {                                                                \
+            noteLock();                                                                    \
+            static auto* real = reinterpret_cast<int (*)(Arg)>(dlsym(RTLD_NEXT, #name));   \
+            return real(arg);                                                              \
+        }
+    ALT_AUDIT_FORWARD(pthread_mutex_lock, pthread_mutex_t*)
+    ALT_AUDIT_FORWARD(pthread_mutex_trylock, pthread_mutex_t*)
+    ALT_AUDIT_FORWARD(pthread_rwlock_rdlock, pthread_rwlock_t*)
+    ALT_AUDIT_FORWARD(pthread_rwlock_wrlock, pthread_rwlock_t*)
+    #undef ALT_AUDIT_FORWARD
+}
+#else
+void* operator new(std::size_t size) {
+    noteAllocation();
+    if (auto* ptr = std::malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { if (ptr != nullptr) noteFree(); std::free(ptr); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete(ptr); }
+#endif
+
+namespace {
+    void setParameter(juce::AudioProcessor& processor, const juce::String& id, float value) {
+        for (auto* param : processor.getParameters())
+            if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+                if (withId->paramID == id)
+                    withId->setValueNotifyingHost(value);
+    }
+
+    struct Mode {
+        const char* name;
+        int numChannels;
+        bool async;
+        bool linked;
+        bool bypassed;
+    };
+
+    // a parameter change made while playing, watched from the block it lands in until the
+    // processor has settled in the new mode
+    struct Switch {
+        const char* name;
+        const char* paramID;
+        float value;
+    };
+
+    // stands in for the host: with a listener attached, anything the audio thread reports to
+    // the host (latency, display updates) takes the processor's listener lock and is caught
+    struct HostListener : juce::AudioProcessorListener {
+        void audioProcessorParameterChanged(juce::AudioProcessor*, int, float) override {}
+        void audioProcessorChanged(juce::AudioProcessor*, const ChangeDetails&) override {}
+    };
+
+    // one prepared configuration, fed blocks of noise
+    class Session {
+    public:
+        Session(AltDenoiserProcessor& p, const Mode& mode, double rate, int size)
+            : processor(p), numChannels(mode.numChannels), sampleRate(rate), blockSize(size),
+              // twice the announced size, so the block splitting is audited as well
+              buffer(mode.numChannels, 2 * size) {
+            setParameter(processor, "async_mode", mode.async ? 1.0f : 0.0f);
+            setParameter(processor, "stereo_link", mode.linked ? 1.0f : 0.0f);
+            setParameter(processor, "latency_mode", 1.0f);
+            setParameter(processor, "bypass", mode.bypassed ? 1.0f : 0.0f);
+            setParameter(processor, "bypass_warm", 0.0f);
+            auto layout = numChannels == 1 ? juce::AudioChannelSet::mono() : juce::AudioChannelSet::stereo();
+            juce::AudioProcessor::BusesLayout buses;
+            buses.inputBuses.add(layout);
+            buses.outputBuses.add(layout);
+            processor.setBusesLayout(buses);
+            processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+        }
+
+        ~Session() { processor.releaseResources(); }
+
+        int getBlocksFor(double seconds) const { return juce::jmax(1, (int)(seconds * sampleRate) / blockSize); }
+
+        void run(int numBlocks, bool watch) {
+            for (int i = 0; i < numBlocks; ++i)
+                runBlock(i % 16 == 15 ? 2 * blockSize : blockSize, watch);
+        }
+
+        void start() {
+            numAllocations.store(0);
+            numFrees.store(0);
+            numLocks.store(0);
+        }
+        // true if processBlock stayed clean since start()
+        bool report(const char* name) const {
+            int allocations = numAllocations.load(), frees = numFrees.load(), locks = numLocks.load();
+            bool clean = allocations == 0 && frees == 0 && locks == 0;
+            std::printf("%-6s %-16s %6.0f Hz %5d  allocs %d  frees %d  locks %d\n", clean ? "ok" : "FAIL",
+                        name, sampleRate, blockSize, allocations, frees, locks);
+            return clean;
+        }
+
+    private:
+        void runBlock(int numSamples, bool watch) {
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < numSamples; ++i)
+                    block.setSample(ch, i, (random.nextFloat() * 2.0f - 1.0f) * 0.1f);
+            auditing = watch;
+            processor.processBlock(block, midi);
+            auditing = false;
+        }
+
+        AltDenoiserProcessor& processor;
+        int numChannels;
+        double sampleRate;
+        int blockSize;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        juce::Random random { 7 };
+    };
+
+    // the first blocks after prepareToPlay, which swap the model in, prime the FIFOs and fade
+    // the wet path in; leaving bypass goes through the same reset, and is audited as a switch
+    int getWarmupBlocks(const Session& session) { return session.getBlocksFor(0.5) + 4; }
+
+    // true if processBlock stayed clean
+    bool audit(AltDenoiserProcessor& processor, const Mode& mode, double sampleRate, int blockSize, double seconds) {
+        Session session(processor, mode, sampleRate, blockSize);
+        session.run(getWarmupBlocks(session), false);
+        session.start();
+        session.run(juce::jmax(50, session.getBlocksFor(seconds)), true);
+        return session.report(mode.name);
+    }
+
+    // every switch in turn on one stereo session; true if all of them stayed clean
+    bool auditSwitches(AltDenoiserProcessor& processor, double sampleRate, int blockSize) {
+        // bypass is held long enough to fade out and go cold, so leaving it resets the channels
+        const Switch switches[] = {
+            { "bypass sync",    "bypass",       1.0f },
+            { "unbypass sync",  "bypass",       0.0f },
+            { "sync > async",   "async_mode",   1.0f },
+            { "low latency",    "latency_mode", 0.0f },
+            { "safe latency",   "latency_mode", 1.0f },
+            { "bypass async",   "bypass",       1.0f },
+            { "unbypass async", "bypass",       0.0f },
+            { "async > sync",   "async_mode",   0.0f },
+            { "link",           "stereo_link",  1.0f },
+            { "unlink",         "stereo_link",  0.0f },
+        };
+        Session session(processor, { "switch", 2, false, false, false }, sampleRate, blockSize);
+        session.run(getWarmupBlocks(session), false);
+        bool clean = true;
+        for (const auto& change : switches) {
+            setParameter(processor, change.paramID, change.value);
+            session.start();
+            // the mode changes once every worker has parked, then the wet path warms up and fades in
+            session.run(session.getBlocksFor(0.5) + 4, true);
+            clean = session.report(change.name) && clean;
+        }
+        return clean;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInit; // the processor's parameters need the message manager
+
+    double seconds = 1.0;
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (juce::String(argv[i]) == "--seconds") seconds = juce::jmax(0.1, juce::String(argv[i + 1]).getDoubleValue());
+
+    AltDenoiserProcessor processor;
+    auto waitStart = juce::Time::getMillisecondCounterHiRes();
+    while (processor.getModelState() == ModelLoader::State::loading
+           && juce::Time::getMillisecondCounterHiRes() - waitStart < 60000.0)
+        juce::Thread::sleep(10);
+    if (processor.getModelState() != ModelLoader::State::ready) {
+        std::fprintf(stderr, "model failed to load\n");
+        return 1;
+    }
+
+    // as if an editor were open, so handing samples to the spectrogram is audited too
+    processor.getSpectrum().setActive(true);
+    HostListener host;
+    processor.addListener(&host);
+
+    const Mode modes[] = {
+        { "mono",   1, false, false, false },
+        { "sync",   2, false, false, false },
+        { "async",  2, true,  false, false },
+        { "link",   2, false, true,  false },
+        { "bypass", 2, false, false, true  },
+    };
+    int numFailed = 0;
+    for (const auto& mode : modes)
+        for (double sampleRate : { 44100.0, 48000.0, 96000.0 })
+            for (int blockSize : { 32, 64, 128, 256, 480, 512, 1024, 2048 })
+                if (!audit(processor, mode, sampleRate, blockSize, seconds)) ++numFailed;
+    for (double sampleRate : { 44100.0, 48000.0, 96000.0 })
+        for (int blockSize : { 32, 256, 2048 })
+            if (!auditSwitches(processor, sampleRate, blockSize)) ++numFailed;
+
+    processor.removeListener(&host);
+    std::printf("%d configuration(s) failed\n", numFailed);
+    return numFailed == 0 ? 0 : 1;
+}